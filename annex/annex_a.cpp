@@ -17,6 +17,7 @@
 #include <range/v3/view/unique.hpp>
 #include <transranger_view.hpp>
 #include <transrangers.hpp>
+#include <transrangers_ext.hpp>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -54,14 +55,7 @@ bool same_output(Range &rng, RangeAdaptor ra, Transranger tr) {
   for (const auto &x : v)
     res1.push_back(x);
 
-  auto rgr = tr(transrangers::all(rng));
-  using ranger_value_type = std::remove_cv_t<std::remove_reference_t<
-      decltype(*std::declval<typename decltype(rgr)::cursor>())>>;
-  std::vector<ranger_value_type> res2;
-  rgr([&](auto p) {
-    res2.push_back(*p);
-    return true;
-  });
+  auto res2 = transrangers::to_vector(tr(transrangers::all(rng)));
 
   return res1 == res2;
 }
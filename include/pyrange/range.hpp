@@ -18,7 +18,7 @@ namespace py {
  * @tparam T
  */
 template <typename T> struct RangeIterator {
-  using iterator_category = std::output_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
   using difference_type = std::ptrdiff_t;
   using value_type = T;
   using pointer = T *;               // or also value_type*
@@ -111,6 +111,143 @@ template <typename T> struct RangeIterator {
     ++(*this);
     return temp;
   }
+
+  // random access: the value is the position, so these are plain arithmetic
+  CONSTEXPR14 auto operator--() -> RangeIterator & {
+    --this->i;
+    return *this;
+  }
+  CONSTEXPR14 auto operator--(int) -> RangeIterator {
+    auto temp = *this;
+    --(*this);
+    return temp;
+  }
+  CONSTEXPR14 auto operator+=(difference_type n) -> RangeIterator & {
+    this->i += static_cast<T>(n);
+    return *this;
+  }
+  CONSTEXPR14 auto operator-=(difference_type n) -> RangeIterator & {
+    this->i -= static_cast<T>(n);
+    return *this;
+  }
+  constexpr auto operator+(difference_type n) const -> RangeIterator {
+    return RangeIterator{T(this->i + static_cast<T>(n))};
+  }
+  friend constexpr auto operator+(difference_type n, const RangeIterator &it)
+      -> RangeIterator {
+    return it + n;
+  }
+  constexpr auto operator-(difference_type n) const -> RangeIterator {
+    return RangeIterator{T(this->i - static_cast<T>(n))};
+  }
+  constexpr auto operator-(const RangeIterator &other) const
+      -> difference_type {
+    return static_cast<difference_type>(this->i) -
+           static_cast<difference_type>(other.i);
+  }
+  constexpr auto operator[](difference_type n) const -> T {
+    return this->i + static_cast<T>(n); /* in T, so lanes form an iota */
+  }
+  constexpr auto operator<(const RangeIterator &other) const -> bool {
+    return this->i < other.i;
+  }
+  constexpr auto operator>(const RangeIterator &other) const -> bool {
+    return other.i < this->i;
+  }
+  constexpr auto operator<=(const RangeIterator &other) const -> bool {
+    return !(other.i < this->i);
+  }
+  constexpr auto operator>=(const RangeIterator &other) const -> bool {
+    return !(this->i < other.i);
+  }
+};
+
+/**
+ * @brief StepRangeIterator
+ *
+ * Random-access iterator of `StepRange`: the `n`-th value is
+ * `start + n * step`, computed on dereference.
+ *
+ * @tparam T
+ */
+template <typename T> struct StepRangeIterator {
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = T;
+  using pointer = const T *;
+  using reference = T;
+
+  T start;
+  T step;
+  difference_type n;
+
+  constexpr auto operator*() const -> T {
+    return T(start + static_cast<T>(n) * step);
+  }
+  constexpr auto operator[](difference_type k) const -> T {
+    return T(start + static_cast<T>(n + k) * step);
+  }
+
+  CONSTEXPR14 auto operator++() -> StepRangeIterator & {
+    ++n;
+    return *this;
+  }
+  CONSTEXPR14 auto operator++(int) -> StepRangeIterator {
+    auto temp = *this;
+    ++n;
+    return temp;
+  }
+  CONSTEXPR14 auto operator--() -> StepRangeIterator & {
+    --n;
+    return *this;
+  }
+  CONSTEXPR14 auto operator--(int) -> StepRangeIterator {
+    auto temp = *this;
+    --n;
+    return temp;
+  }
+  CONSTEXPR14 auto operator+=(difference_type k) -> StepRangeIterator & {
+    n += k;
+    return *this;
+  }
+  CONSTEXPR14 auto operator-=(difference_type k) -> StepRangeIterator & {
+    n -= k;
+    return *this;
+  }
+  constexpr auto operator+(difference_type k) const -> StepRangeIterator {
+    return StepRangeIterator{start, step, n + k};
+  }
+  friend constexpr auto operator+(difference_type k,
+                                  const StepRangeIterator &it)
+      -> StepRangeIterator {
+    return it + k;
+  }
+  constexpr auto operator-(difference_type k) const -> StepRangeIterator {
+    return StepRangeIterator{start, step, n - k};
+  }
+  constexpr auto operator-(const StepRangeIterator &other) const
+      -> difference_type {
+    return n - other.n;
+  }
+
+  constexpr auto operator==(const StepRangeIterator &other) const -> bool {
+    return n == other.n;
+  }
+  constexpr auto operator!=(const StepRangeIterator &other) const -> bool {
+    return n != other.n;
+  }
+  constexpr auto operator<(const StepRangeIterator &other) const -> bool {
+    return n < other.n;
+  }
+  constexpr auto operator>(const StepRangeIterator &other) const -> bool {
+    return n > other.n;
+  }
+  constexpr auto operator<=(const StepRangeIterator &other) const -> bool {
+    return n <= other.n;
+  }
+  constexpr auto operator>=(const StepRangeIterator &other) const -> bool {
+    return n >= other.n;
+  }
 };
 
 /**
@@ -240,4 +377,57 @@ template <typename T> CONSTEXPR14 auto range(T stop) -> Range<T> {
   return range(T(0), stop);
 }
 
+/**
+ * @brief StepRange
+ *
+ * The values `start, start + step, ...` strictly before `stop`, as returned
+ * by `range(start, stop, step)`.
+ *
+ * @tparam T
+ */
+template <typename T> struct StepRange {
+  using iterator = StepRangeIterator<T>;
+  using value_type = T;
+  using key_type = T;
+
+  T start;
+  T step;
+  size_t count;
+
+  constexpr auto begin() const -> iterator { return iterator{start, step, 0}; }
+  constexpr auto end() const -> iterator {
+    return iterator{start, step, static_cast<std::ptrdiff_t>(count)};
+  }
+  constexpr auto empty() const -> bool { return count == 0; }
+  constexpr auto size() const -> size_t { return count; }
+  constexpr auto operator[](size_t n) const -> T {
+    return T(start + static_cast<T>(n) * step);
+  } // no bounds checking
+};
+
+/**
+ * @brief range(T start, T stop, T step)
+ *
+ * Like Python's `range(start, stop, step)`: the values from `start` in
+ * increments of `step` (which can be negative, but not zero) up to, not
+ * including, `stop`.
+ *
+ * @tparam T
+ * @param start
+ * @param stop
+ * @param step
+ * @return StepRange<T>
+ */
+template <typename T>
+CONSTEXPR14 auto range(T start, T stop, T step) -> StepRange<T> {
+  auto count = size_t(0);
+  if (step > T(0)) {
+    if (start < stop)
+      count = static_cast<size_t>((stop - start - T(1)) / step) + 1;
+  } else if (stop < start) { /* step < 0 */
+    count = static_cast<size_t>((start - stop - T(1)) / T(-step)) + 1;
+  }
+  return StepRange<T>{start, step, count};
+}
+
 } // namespace py
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
+#include "range.hpp"
+
 namespace fun {
 
 namespace detail {
@@ -137,6 +140,65 @@ template <typename T> struct RobinIterableWrapper {
   auto end() const -> RobinIterator<T> { return RobinIterator<T>{node}; }
   // auto size() const -> size_t { return rr->cycle.size() - 1; }
 };
+
+/**
+ * @brief CompactRobinIterator
+ *
+ * Iterator of `CompactRobin::exclude`: the current part, incremented modulo
+ * the number of parts.
+ *
+ * @tparam T
+ */
+template <typename T> struct CompactRobinIterator {
+  T cur;
+  T num_parts;
+
+  auto operator!=(const CompactRobinIterator &other) const -> bool {
+    return cur != other.cur;
+  }
+
+  auto operator==(const CompactRobinIterator &other) const -> bool {
+    return cur == other.cur;
+  }
+
+  auto operator++() -> CompactRobinIterator & {
+    if (++cur == num_parts)
+      cur = T(0);
+    return *this;
+  }
+
+  auto operator*() const -> const T & { return cur; }
+};
+
+/**
+ * @brief CompactRobinIterableWrapper
+ *
+ * Range of the parts other than `from_part`, starting from the one after it.
+ *
+ * @tparam T
+ */
+template <typename T> struct CompactRobinIterableWrapper {
+  T from_part;
+  T num_parts;
+
+  auto begin() const -> CompactRobinIterator<T> {
+    return ++CompactRobinIterator<T>{from_part, num_parts};
+  }
+
+  auto end() const -> CompactRobinIterator<T> {
+    return CompactRobinIterator<T>{from_part, num_parts};
+  }
+};
+
+/* f(part, other) for all parts: two contiguous index runs per part */
+template <typename T, typename F> void robin_exclude_all(T num_parts, F &f) {
+  for (auto part = T(0); part != num_parts; ++part) {
+    for (auto other = T(part + 1); other != num_parts; ++other)
+      f(part, other);
+    for (auto other = T(0); other != part; ++other)
+      f(part, other);
+  }
+}
 } // namespace detail
 
 /**
@@ -185,6 +247,141 @@ template <typename T> struct Robin {
   auto exclude(T from_part) const -> detail::RobinIterableWrapper<T> {
     return detail::RobinIterableWrapper<T>{&this->cycle[from_part]};
   }
+
+  /**
+   * @brief size
+   *
+   * @return T the number of parts
+   */
+  auto size() const -> T { return static_cast<T>(this->cycle.size()); }
+
+  /**
+   * @brief exclude_all
+   *
+   * Calls `f(part, other)` for every part and every other part, in the order
+   * of `exclude(part)`, computing the indices instead of following the list.
+   *
+   * @tparam F
+   * @param f
+   */
+  template <typename F> void exclude_all(F f) const {
+    detail::robin_exclude_all(this->size(), f);
+  }
 };
 
+/**
+ * @brief Compact round robin
+ *
+ * Pointer-free variant of `Robin`: as the cycle always visits the parts in
+ * index order, it is not stored at all and `exclude` computes the next part
+ * with a wrap-around increment instead of loading a `next` pointer.
+ * Produces the same sequences as `Robin`.
+ *
+ * @tparam T
+ */
+template <typename T> struct CompactRobin {
+  T num_parts;
+
+  /**
+   * @brief Construct a new CompactRobin object
+   *
+   * @param num_parts
+   */
+  explicit CompactRobin(T num_parts) : num_parts{num_parts} {}
+
+  /**
+   * @brief exclude
+   *
+   * The parts other than `from_part`, starting from the one after it.
+   *
+   * @param from_part
+   * @return detail::CompactRobinIterableWrapper<T>
+   */
+  auto exclude(T from_part) const -> detail::CompactRobinIterableWrapper<T> {
+    return {from_part, this->num_parts};
+  }
+
+  /**
+   * @brief size
+   *
+   * @return T the number of parts
+   */
+  auto size() const -> T { return this->num_parts; }
+
+  /**
+   * @brief exclude_all
+   *
+   * See `Robin::exclude_all`.
+   *
+   * @tparam F
+   * @param f
+   */
+  template <typename F> void exclude_all(F f) const {
+    detail::robin_exclude_all(this->num_parts, f);
+  }
+};
+
+/**
+ * @brief RobinExcludeRanger
+ *
+ * Transrangers source returned by `robin_exclude`: the parts other than
+ * `part` are the index runs `part + 1 .. n - 1` and `0 .. part - 1`, fed to
+ * the consumer by two plain loops. Random access (see
+ * `transrangers::is_random_access_ranger`), so sized sinks and adaptors such
+ * as `take` or `zip2` run a single index loop over it.
+ *
+ * @tparam T
+ */
+template <typename T> struct RobinExcludeRanger {
+  using cursor = py::RangeIterator<T>;
+
+  template <typename Dst> bool operator()(Dst dst) {
+    for (; this->pos < this->split;) {
+      auto p = cursor{static_cast<T>(this->part + 1 + this->pos++)};
+      if (!dst(p))
+        return false;
+    }
+    for (; this->pos < this->count;) {
+      auto p = cursor{static_cast<T>(this->pos++ - this->split)};
+      if (!dst(p))
+        return false;
+    }
+    return true;
+  }
+
+  auto size() const -> std::size_t { return this->count - this->pos; }
+
+  auto at(std::size_t i) const -> cursor {
+    auto k = this->pos + i;
+    return cursor{static_cast<T>(k < this->split ? this->part + 1 + k
+                                                 : k - this->split)};
+  }
+
+  void advance(std::size_t n) { this->pos += n; }
+
+  T part;
+  std::size_t split; /* elements of the first run */
+  std::size_t count; /* elements in all */
+  std::size_t pos = 0;
+};
+
+/**
+ * @brief robin_exclude
+ *
+ * Transrangers source over `robin.exclude(part)` (for `Robin` or
+ * `CompactRobin`) that does not traverse the cycle.
+ *
+ * @tparam RobinT
+ * @tparam T
+ * @param robin
+ * @param part
+ * @return RobinExcludeRanger<T>
+ */
+template <typename RobinT, typename T>
+auto robin_exclude(const RobinT &robin, T part) -> RobinExcludeRanger<T> {
+  auto n = static_cast<std::size_t>(robin.size());
+  auto p = static_cast<std::size_t>(part);
+  return {part, n - 1 - p, n - 1};
+}
+
 } // namespace fun
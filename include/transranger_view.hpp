@@ -13,11 +13,31 @@
 #pragma once
 #endif
 
+#include "transrangers.hpp"
+
 #include <range/v3/range_fwd.hpp>
 #include <range/v3/utility/semiregular_box.hpp>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#if __has_include(<ranges>)
+#include <ranges>
+#endif
 #include <type_traits>
 #include <utility>
 
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
 namespace transrangers {
 
 /* Ranger -> Range-v3 view adaptors */
@@ -134,6 +154,99 @@ private:
   ranges::semiregular_box<Ranger> rgr;
 };
 
+/* Input view pulling up to K cursors from the ranger per resume into a
+ * buffer it owns. Iterators hold a pointer to the view and their index into
+ * the buffer, so ++ is an index increment most of the time and copying an
+ * iterator is O(1). As with input_view, cursors must remain valid after the
+ * ranger is resumed. See buffered_view(rgr) below for when to use it.
+ */
+template <typename Ranger, std::size_t K> class buffered_view;
+
+template <typename Ranger, std::size_t K> class buffered_iterator {
+  using view_type = buffered_view<Ranger, K>;
+  using cursor = typename Ranger::cursor;
+
+  struct postfix_proxy {
+    decltype(auto) operator*() const { return *p; }
+
+    cursor p;
+  };
+
+public:
+  using value_type = std::remove_cv_t<
+      std::remove_reference_t<decltype(*std::declval<cursor>())>>;
+  using difference_type = std::ptrdiff_t;
+
+  buffered_iterator() = default;
+  buffered_iterator(view_type *v) : v{v} {}
+
+  decltype(auto) operator*() const { return *v->buf[i]; }
+  buffered_iterator &operator++() {
+    if (++i == v->n && !v->done) {
+      v->fill();
+      i = 0;
+    }
+    return *this;
+  }
+  postfix_proxy operator++(int) {
+    postfix_proxy x{v->buf[i]};
+    ++*this;
+    return x;
+  }
+
+  friend bool operator==(const buffered_iterator &x, const sentinel &) {
+    return x.at_end();
+  }
+  friend bool operator!=(const buffered_iterator &x, const sentinel &y) {
+    return !(x == y);
+  }
+
+private:
+  bool at_end() const { return i == v->n; }
+
+  view_type *v = nullptr;
+  std::size_t i = 0;
+};
+
+template <typename Ranger, std::size_t K>
+class buffered_view : public ranges::view_base {
+  static_assert(K > 0);
+
+public:
+  using iterator = buffered_iterator<Ranger, K>;
+
+  buffered_view() = default;
+  buffered_view(Ranger rgr) : rgr{std::move(rgr)} {}
+
+  /* Single pass: begin() is to be called once, and the view must not be
+   * moved afterwards.
+   */
+  iterator begin() {
+    fill();
+    return {this};
+  }
+  auto end() { return sentinel{}; }
+
+private:
+  friend iterator;
+
+  /* n == 0 only when the ranger is exhausted */
+  void fill() {
+    std::size_t m = 0;
+    auto first = buf.data();
+    done = rgr([&](const auto &p) {
+      first[m++] = p;
+      return m < K;
+    });
+    n = m;
+  }
+
+  ranges::semiregular_box<Ranger> rgr;
+  std::array<typename Ranger::cursor, K> buf;
+  std::size_t n = 0;
+  bool done = false;
+};
+
 } // namespace detail::view
 
 template <typename Ranger> auto input_view(Ranger rgr) {
@@ -146,6 +259,223 @@ template <typename Ranger> auto forward_view(Ranger rgr) {
   return view<Ranger, forward_iterator<Ranger>>{std::move(rgr)};
 }
 
+/* Opt-in alternative to input_view pulling K cursors per resume of rgr.
+ * The buffer round trip costs a store and a load per element, which only
+ * pays off when resuming rgr is expensive, as with zip of filtered inputs.
+ * Elsewhere it is a regression; input_view vs buffered_view, g++ 12 -O3,
+ * 1M ints:
+ *   zip2 of two filters:         6.4ms vs 6.0ms
+ *   transform(filter(all)):      1.5ms vs 2.2ms
+ *   transform(ranger_join(all)): 1.4ms vs 2.5ms
+ * Prefer input_view unless the pipeline is zip-like and measured faster.
+ */
+template <std::size_t K = 64, typename Ranger> auto buffered_view(Ranger rgr) {
+  return detail::view::buffered_view<Ranger, K>{std::move(rgr)};
+}
+
+/* Range-v3 / std::ranges view -> ranger adaptor */
+
+namespace detail::view {
+
+template <typename View>
+using iterator_t = decltype(std::begin(std::declval<View &>()));
+template <typename View>
+using sentinel_t = decltype(std::end(std::declval<View &>()));
+
+template <typename View, typename = void>
+struct is_contiguous : std::false_type {};
+template <typename View>
+struct is_contiguous<View, std::void_t<decltype(std::data(std::declval<View &>())),
+                                       decltype(std::size(std::declval<View &>()))>>
+    : std::is_pointer<decltype(std::data(std::declval<View &>()))> {};
+
+template <typename View, typename = void>
+struct is_sized : std::false_type {};
+template <typename View>
+struct is_sized<View, std::void_t<decltype(std::size(std::declval<View &>()))>>
+    : std::true_type {};
+
+/* C++20 iterators (e.g. those of views::iota) may be random access while
+ * declaring a weaker legacy iterator_category.
+ */
+template <typename Iterator>
+constexpr bool random_access_v =
+#if defined(__cpp_lib_ranges)
+    std::random_access_iterator<Iterator> ||
+#endif
+    transrangers::detail::is_random_access<Iterator>::value;
+
+/* Rvalue views that don't borrow their elements are kept alive by the
+ * ranger, in a shared_ptr so that ranger copies don't invalidate iterators.
+ */
+template <typename View>
+constexpr bool borrowed_v =
+#if defined(__cpp_lib_ranges)
+    std::ranges::borrowed_range<View>;
+#else
+    false;
+#endif
+
+template <typename View, bool = borrowed_v<View>> struct view_holder {
+  explicit view_holder(View v) : p{std::make_shared<View>(std::move(v))} {}
+  View &get() const { return *p; }
+
+  std::shared_ptr<View> p;
+};
+
+template <typename View> struct view_holder<View, true> {
+  explicit view_holder(View v) : v{std::move(v)} {}
+  View &get() { return v; }
+
+  View v;
+};
+
+/* Lvalue ranges are referred to, as with all() */
+template <typename Range> struct range_ref {
+  explicit range_ref(Range &rng) : p{&rng} {}
+  Range &get() const { return *p; }
+
+  Range *p;
+};
+
+template <typename View>
+using holder_t =
+    std::conditional_t<std::is_lvalue_reference<View>::value,
+                       range_ref<std::remove_reference_t<View>>,
+                       view_holder<View>>;
+
+/* Pointer loop over contiguous views */
+template <typename Holder, typename Pointer>
+struct contiguous_view_ranger : all_ranger<Pointer> {
+  Holder holder;
+};
+
+/* Counted loop over sized views, random access if the iterators are */
+template <typename Holder, typename Iterator> struct sized_view_ranger {
+  using cursor = Iterator;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    if constexpr (random_access_v<Iterator>) {
+      auto it = first, last = first + static_cast<std::ptrdiff_t>(n);
+      while (it != last) {
+        auto p = it;
+        ++it;
+        if (!dst(p)) {
+          n -= static_cast<std::size_t>(it - first);
+          first = it;
+          return false;
+        }
+      }
+      first = it;
+    } else {
+      auto it = first;
+      for (auto k = n; k; --k) {
+        auto p = it;
+        ++it;
+        if (!dst(p)) {
+          first = it;
+          n = k - 1;
+          return false;
+        }
+      }
+      first = it;
+    }
+    n = 0;
+    return true;
+  }
+
+  std::size_t size() const { return n; }
+  template <typename I = Iterator,
+            typename = std::enable_if_t<random_access_v<I>>>
+  cursor at(std::size_t i) {
+    return first + static_cast<std::ptrdiff_t>(i);
+  }
+  template <typename I = Iterator,
+            typename = std::enable_if_t<random_access_v<I>>>
+  void advance(std::size_t k) {
+    first += static_cast<std::ptrdiff_t>(k);
+    n -= k;
+  }
+
+  Holder holder;
+  Iterator first;
+  std::size_t n;
+};
+
+/* Iterator/sentinel loop over any other view */
+template <typename Holder, typename Iterator, typename Sentinel>
+struct iterator_view_ranger {
+  using cursor = Iterator;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    auto it = first;
+    while (it != last) {
+      auto p = it;
+      ++it;
+      if (!dst(p)) {
+        first = it;
+        return false;
+      }
+    }
+    first = it;
+    return true;
+  }
+
+  Holder holder;
+  Iterator first;
+  Sentinel last;
+};
+
+} // namespace detail::view
+
+/**
+ * @brief from_view
+ *
+ * Ranger over the view `v` (range-v3, std::ranges or any range). As with
+ * `all`, lvalue ranges are referred to, not copied; rvalue views are stored
+ * in the ranger unless they are borrowed ranges.
+ * Contiguous views (`span`, contiguous `subrange`s, `string_view`) are
+ * lowered to a pointer loop like `all` over a `std::vector`, sized ones (e.g.
+ * `views::iota(0, n)`) to a counted loop that is random access if their
+ * iterators are, so that the view's own end test is never evaluated. Other
+ * views get the ordinary iterator/sentinel loop.
+ *
+ * @tparam View
+ * @param v
+ * @return auto
+ */
+template <typename View> auto from_view(View &&v) {
+  using namespace detail::view;
+  using range_type = std::remove_reference_t<View>;
+  using holder_type = holder_t<View>;
+
+  holder_type holder{std::forward<View>(v)};
+  auto &rng = holder.get();
+  if constexpr (is_contiguous<range_type>::value) {
+    auto first = std::data(rng);
+    auto last = first + std::size(rng);
+    return transrangers::detail::stage(
+        "from_view", contiguous_view_ranger<holder_type, decltype(first)>{
+                         {first, last}, std::move(holder)});
+  } else if constexpr (is_sized<range_type>::value) {
+    auto first = std::begin(rng);
+    auto n = static_cast<std::size_t>(std::size(rng));
+    return transrangers::detail::stage(
+        "from_view", sized_view_ranger<holder_type, iterator_t<range_type>>{
+                         std::move(holder), first, n});
+  } else {
+    auto first = std::begin(rng);
+    auto last = std::end(rng);
+    return transrangers::detail::stage(
+        "from_view",
+        iterator_view_ranger<holder_type, iterator_t<range_type>,
+                             sentinel_t<range_type>>{std::move(holder), first,
+                                                     last});
+  }
+}
+
 } // namespace transrangers
 
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
 #endif
@@ -15,6 +15,8 @@
 #pragma once
 #endif
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
 #include <optional>
 #include <tuple>
@@ -32,6 +34,28 @@
 #define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
 #endif
 
+/* Batch width requested by the sinks able to process batches (see
+ * batch_consumer below); 0 or 1 keeps them on the scalar protocol.
+ * Compilers that already auto-vectorize the scalar pipeline (e.g. GCC at
+ * -O3) may not benefit from batching.
+ */
+#if !defined(TRANSRANGERS_BATCH_WIDTH)
+#define TRANSRANGERS_BATCH_WIDTH 0
+#endif
+
+/* Ownership: transrangers take their input rangers and function objects by
+ * value and move them in, so each is stored once and move-only function
+ * objects are accepted (the resulting ranger is then move-only). `all` and
+ * the `skip_*` functions refer to lvalue ranges and own rvalue ones (see
+ * `all_copy`); `hash_join` and `distinct` own the tables they build. Pass
+ * `std::ref`/`std::cref` to hold a large function object by reference.
+ *
+ * Constant evaluation: the rangers and sinks of this header (except `join`,
+ * which keeps an interrupted subranger in a `std::optional`) are `constexpr`,
+ * so pipelines over literal ranges can run at compile time (see `to_array`
+ * in transrangers_ext.hpp). Not under TRANSRANGERS_PROFILE.
+ */
+
 namespace transrangers {
 
 /**
@@ -65,82 +89,494 @@ template <typename Cursor, typename F> struct ranger_class : F {
  * @param f
  * @return auto
  */
-template <typename Cursor, typename F> auto ranger(F f) {
-  return ranger_class<Cursor, F>{f};
+template <typename Cursor, typename F> constexpr auto ranger(F f) {
+  return ranger_class<Cursor, F>{std::move(f)};
+}
+
+// sized and random-access rangers
+
+/**
+ * @brief is_sized_ranger
+ *
+ * A ranger is sized if `rgr.size()` returns the number of elements still to
+ * be produced.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger, typename = void>
+struct is_sized_ranger : std::false_type {};
+
+template <typename Ranger>
+struct is_sized_ranger<Ranger,
+                       std::void_t<decltype(std::declval<const Ranger &>().size())>>
+    : std::true_type {};
+
+/**
+ * @brief is_random_access_ranger
+ *
+ * A random-access ranger is a sized ranger that additionally provides
+ * `rgr.at(i)`, returning the cursor to the `i`-th remaining element
+ * (`i < rgr.size()`), and `rgr.advance(n)`, which drops the next `n`
+ * elements (`n <= rgr.size()`). Transrangers use these to compute bounds once
+ * and run a single index loop instead of resuming their inputs element by
+ * element.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger, typename = void>
+struct is_random_access_ranger : std::false_type {};
+
+template <typename Ranger>
+struct is_random_access_ranger<
+    Ranger, std::void_t<decltype(std::declval<const Ranger &>().size()),
+                        decltype(std::declval<Ranger &>().at(std::size_t{})),
+                        decltype(std::declval<Ranger &>().advance(
+                            std::size_t{}))>> : std::true_type {};
+
+/**
+ * @brief has_size_hint
+ *
+ * A ranger has a size hint if it is sized or provides `rgr.size_hint()`, an
+ * upper bound of the number of elements still to be produced. Sinks that
+ * materialize the range use it to reserve memory up front.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger, typename = void>
+struct has_size_hint : is_sized_ranger<Ranger> {};
+
+template <typename Ranger>
+struct has_size_hint<
+    Ranger, std::void_t<decltype(std::declval<const Ranger &>().size_hint())>>
+    : std::true_type {};
+
+/**
+ * @brief hinted_ranger_class
+ *
+ * A `ranger_class` carrying a size hint fixed on construction. As the ranger
+ * only ever produces fewer elements, the hint stays a valid upper bound.
+ *
+ * @tparam Cursor
+ * @tparam F
+ */
+template <typename Cursor, typename F> struct hinted_ranger_class : F {
+  using cursor = Cursor;
+
+  constexpr std::size_t size_hint() const { return hint; }
+
+  std::size_t hint;
+};
+
+template <typename Cursor, typename F>
+constexpr auto hinted_ranger(F f, std::size_t hint) {
+  return hinted_ranger_class<Cursor, F>{std::move(f), hint};
+}
+
+namespace detail {
+
+template <typename Ranger>
+constexpr bool has_size_hint_v = has_size_hint<Ranger>::value;
+
+template <typename Ranger> constexpr std::size_t size_hint(const Ranger &rgr) {
+  if constexpr (is_sized_ranger<Ranger>::value)
+    return rgr.size();
+  else
+    return rgr.size_hint();
+}
+
+struct no_size_hint {};
+
+/* Size hint of rgr, if it has one. Taken before rgr is moved into the
+ * transranger built on it.
+ */
+template <typename Ranger> constexpr auto hint_of(const Ranger &rgr) {
+  if constexpr (has_size_hint<Ranger>::value)
+    return size_hint(rgr);
+  else {
+    (void)rgr;
+    return no_size_hint{};
+  }
+}
+
+/* ranger<Cursor>(f), carrying hint if there is one. */
+template <typename Cursor, typename F>
+constexpr auto ranger_hinted_by(std::size_t hint, F f) {
+  return hinted_ranger<Cursor>(std::move(f), hint);
+}
+
+template <typename Cursor, typename F>
+constexpr auto ranger_hinted_by(no_size_hint, F f) {
+  return ranger<Cursor>(std::move(f));
+}
+
+template <typename Ranger>
+constexpr bool sized_ranger_v = is_sized_ranger<Ranger>::value;
+
+template <typename Ranger>
+constexpr bool random_access_ranger_v = is_random_access_ranger<Ranger>::value;
+
+/* Feeds the first n elements of a random-access ranger to dst. */
+template <typename Ranger, typename Dst>
+constexpr bool run_random_access(Ranger &rgr, std::size_t n, Dst &dst) {
+  for (std::size_t i = 0; i < n;)
+    if (!dst(rgr.at(i++))) {
+      rgr.advance(i);
+      return false;
+    }
+  rgr.advance(n);
+  return true;
+}
+
+} // namespace detail
+
+// batch protocol
+
+/**
+ * @brief batch_consumer
+ *
+ * Marks a consumption function as able to accept, in addition to single
+ * cursors, whole batches of elements. A batch has a compile-time `width`,
+ * `b[i]` accesses lane `i` and `b.active(i)` tells whether the lane holds an
+ * element of the range. Sources that can cheaply produce batches (`all` over
+ * random-access ranges) emit them only when fed a batch consumer directly;
+ * transrangers wrap `dst` into an ordinary consumption function, so batches
+ * never reach stages that can't handle them. A batch consumer processes the
+ * entire batch it is given and returns `false` to stop after it. The batch
+ * width `W` is chosen by the consumer.
+ *
+ * @tparam W
+ * @tparam F
+ */
+template <std::size_t W, typename F> struct batch_consumer : F {
+  static_assert(W > 0);
+  static constexpr std::size_t batch_width = W;
+};
+
+template <std::size_t W, typename F> constexpr auto make_batch_consumer(F f) {
+  return batch_consumer<W, F>{f};
+}
+
+template <typename Dst, typename = void>
+struct is_batch_consumer : std::false_type {};
+
+template <typename Dst>
+struct is_batch_consumer<Dst, std::void_t<decltype(Dst::batch_width)>>
+    : std::true_type {};
+
+/**
+ * @brief span_batch
+ *
+ * `W` consecutive elements of a random-access source starting at cursor `p`.
+ *
+ * @tparam Cursor
+ * @tparam W
+ */
+template <typename Cursor, std::size_t W> struct span_batch {
+  static constexpr std::size_t width = W;
+
+  static constexpr bool active(std::size_t) { return true; }
+  constexpr decltype(auto) operator[](std::size_t i) const { return p[i]; }
+
+  Cursor p;
+};
+
+template <typename T> struct is_batch : std::false_type {};
+template <typename Cursor, std::size_t W>
+struct is_batch<span_batch<Cursor, W>> : std::true_type {};
+
+namespace detail {
+
+/* Batch width requested from their input by the sinks that process
+ * batches (select, min_max, count_if in transrangers_ext.hpp).
+ */
+constexpr std::size_t batch_width =
+    TRANSRANGERS_BATCH_WIDTH > 1 ? TRANSRANGERS_BATCH_WIDTH : 1;
+
+} // namespace detail
+
+// exhaustive consumers
+
+/**
+ * @brief exhaustive_consumer
+ *
+ * Marks a consumption function that never returns `false`, i.e. that always
+ * consumes the whole range (`accumulate`, the `par_*` reductions). Rangers
+ * can then skip the bookkeeping needed to resume after an early stop: `join`
+ * runs every subranger to completion without keeping it around, and
+ * `filter`, `transform` and `unique` propagate the mark upstream.
+ *
+ * @tparam F
+ */
+template <typename F> struct exhaustive_consumer : F {
+  static constexpr bool exhaustive = true;
+};
+
+template <typename F> constexpr auto make_exhaustive_consumer(F f) {
+  return exhaustive_consumer<F>{f};
+}
+
+template <typename Dst, typename = void>
+struct is_exhaustive_consumer : std::false_type {};
+
+template <typename Dst>
+struct is_exhaustive_consumer<Dst, std::void_t<decltype(Dst::exhaustive)>>
+    : std::bool_constant<Dst::exhaustive> {};
+
+namespace detail {
+
+/* Consumption function f marked exhaustive if Dst is. */
+template <typename Dst, typename F> constexpr auto exhaustive_like(F f) {
+  if constexpr (is_exhaustive_consumer<Dst>::value)
+    return make_exhaustive_consumer(f);
+  else
+    return f;
+}
+
+/* Consumption function f with the same marks (batch width, exhaustiveness)
+ * as Dst, for transrangers able to forward everything Dst accepts.
+ */
+template <typename Dst, typename F> constexpr auto consumer_like(F f) {
+  if constexpr (is_batch_consumer<Dst>::value)
+    return exhaustive_like<Dst>(make_batch_consumer<Dst::batch_width>(f));
+  else
+    return exhaustive_like<Dst>(f);
 }
 
+} // namespace detail
+
+namespace detail {
+
+template <typename Cursor>
+using cursor_value_t =
+    std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Cursor>())>>;
+
+template <typename Iterator>
+constexpr bool random_access_v = std::is_base_of<
+    std::random_access_iterator_tag,
+    typename std::iterator_traits<Iterator>::iterator_category>::value;
+
+template <typename Iterator, typename = void>
+struct is_iterator : std::false_type {};
+template <typename Iterator>
+struct is_iterator<Iterator, std::void_t<typename std::iterator_traits<
+                                 Iterator>::iterator_category>>
+    : std::true_type {};
+
+template <typename Iterator, typename = void>
+struct is_random_access : std::false_type {};
+template <typename Iterator>
+struct is_random_access<Iterator, std::enable_if_t<is_iterator<Iterator>::value>>
+    : std::bool_constant<random_access_v<Iterator>> {};
+
+} // namespace detail
+
+#if defined(TRANSRANGERS_PROFILE)
+namespace profile { /* defined in transrangers_profile.hpp */
+
+template <typename Ranger> struct instrumented;
+
+template <typename Ranger, typename... Inputs>
+instrumented<Ranger> make_stage(const char *name, Ranger rgr,
+                                const Inputs &...inputs);
+
+} // namespace profile
+#endif
+
+namespace detail {
+
+/* Marks rgr, built by the adaptor name out of inputs, as a pipeline stage.
+ * Under TRANSRANGERS_PROFILE the stage is instrumented (see
+ * transrangers_profile.hpp); otherwise rgr is returned unchanged.
+ */
+template <typename Ranger, typename... Inputs>
+constexpr auto stage(const char *name, Ranger rgr, const Inputs &...inputs) {
+#if defined(TRANSRANGERS_PROFILE)
+  return profile::make_stage(name, std::move(rgr), inputs...);
+#else
+  (void)name;
+  ((void)inputs, ...);
+  return rgr;
+#endif
+}
+
+} // namespace detail
+
 // all, all_copy
 
+/**
+ * @brief all_ranger
+ *
+ * Ranger over the iterator range `[first, last)`. When `Cursor` is a
+ * random-access iterator, the ranger is random access (see
+ * `is_random_access_ranger`).
+ *
+ * @tparam Cursor
+ */
+template <typename Cursor> struct all_ranger {
+  using cursor = Cursor;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    auto it = first;
+    if constexpr (is_batch_consumer<Dst>::value &&
+                  detail::is_random_access<cursor>::value) {
+      constexpr auto W = Dst::batch_width;
+      while (static_cast<std::size_t>(last - it) >= W) {
+        auto b = span_batch<cursor, W>{it};
+        it += W;
+        if (!dst(b)) {
+          first = it;
+          return false;
+        }
+      }
+    }
+    while (it != last)
+      if (!dst(it++)) {
+        first = it;
+        return false;
+      }
+    return true;
+  }
+
+  template <typename C = Cursor,
+            typename = std::enable_if_t<detail::is_random_access<C>::value>>
+  constexpr std::size_t size() const {
+    return static_cast<std::size_t>(last - first);
+  }
+
+  template <typename C = Cursor,
+            typename = std::enable_if_t<detail::is_random_access<C>::value>>
+  constexpr cursor at(std::size_t i) {
+    return first + static_cast<std::ptrdiff_t>(i);
+  }
+
+  template <typename C = Cursor,
+            typename = std::enable_if_t<detail::is_random_access<C>::value>>
+  constexpr void advance(std::size_t n) {
+    first += static_cast<std::ptrdiff_t>(n);
+  }
+
+  Cursor first, last;
+};
+
+namespace detail {
+
+namespace adl {
+using std::begin;
+template <typename Range>
+using range_iterator_t = decltype(begin(std::declval<Range &>()));
+} // namespace adl
+
+using adl::range_iterator_t;
+
+} // namespace detail
+
 /**
  * @brief all
  *
  * The `all` function takes a range `rng` as input and returns a ranger object.
  * The ranger object represents a range processing operation that can be
- * composed with other ranger operations.
+ * composed with other ranger operations. Lvalue ranges are referred to, not
+ * copied.
  *
  * @tparam Range
  * @param rng
  * @return auto
  */
-template <typename Range> auto all(Range &&rng) {
+template <typename Range,
+          typename = std::enable_if_t<std::is_lvalue_reference<Range>::value>>
+constexpr auto all(Range &&rng) {
   using std::begin;
   using std::end;
   using cursor = decltype(begin(rng));
 
-  return ranger<cursor>([first = begin(rng), last = end(rng)](auto dst)
-                            TRANSRANGERS_HOT_MUTABLE {
-                              auto it = first;
-                              while (it != last)
-                                if (!dst(it++)) {
-                                  first = it;
-                                  return false;
-                                }
-                              return true;
-                            });
+  return detail::stage("all", all_ranger<cursor>{begin(rng), end(rng)});
 }
 
 /**
  * @brief all_copy
  *
- * The `all_copy` struct is a helper struct used in the `all` function. It is
- * used to handle the case when the input range passed to `all` is an rvalue
- * reference. It stores the input range and creates a ranger object using the
- * `all` function.
+ * Ranger returned by `all` (and `skip_first`, `skip_last`, `skip_both`) for
+ * rvalue ranges: the range is moved into the ranger, which iterates over
+ * `[first, last)` of its own copy. Copying or moving an `all_copy` rebases the
+ * position on the new copy of the range, so that the result never refers to
+ * the source.
  *
  * @tparam Range
  */
 template <typename Range> struct all_copy {
-  using ranger = decltype(all(std::declval<Range &>()));
+  using ranger = all_ranger<detail::range_iterator_t<Range>>;
   using cursor = typename ranger::cursor;
 
-  template <typename F> auto operator()(const F &p) { return rgr(p); }
+  constexpr explicit all_copy(Range &&r) : rng(std::move(r)), rgr{all_of(rng)} {}
+
+  /* with mk(rng) giving the all_ranger over part of rng */
+  template <typename F>
+  constexpr all_copy(Range &&r, F mk) : rng(std::move(r)), rgr{mk(rng)} {}
+
+  constexpr all_copy(const all_copy &x) : rng(x.rng), rgr{rebase(rng, x.offsets())} {}
+
+  constexpr all_copy(all_copy &&x) : all_copy(x.offsets(), std::move(x.rng)) {}
+
+  template <typename F> constexpr auto operator()(const F &p) {
+    return rgr(p);
+  }
+
+  template <typename R = ranger>
+  constexpr auto size() const -> decltype(std::declval<const R &>().size()) {
+    return rgr.size();
+  }
+  template <typename R = ranger>
+  constexpr auto at(std::size_t i) -> decltype(std::declval<R &>().at(i)) {
+    return rgr.at(i);
+  }
+  template <typename R = ranger>
+  constexpr auto advance(std::size_t n) -> decltype(std::declval<R &>().advance(n)) {
+    rgr.advance(n);
+  }
 
   Range rng;
-  ranger rgr = all(rng);
+  ranger rgr;
+
+private:
+  using offsets_type = std::pair<std::ptrdiff_t, std::ptrdiff_t>;
+
+  constexpr all_copy(offsets_type off, Range &&r)
+      : rng(std::move(r)), rgr{rebase(rng, off)} {}
+
+  static constexpr ranger all_of(Range &r) {
+    using std::begin;
+    using std::end;
+    return {begin(r), end(r)};
+  }
+
+  static constexpr ranger rebase(Range &r, offsets_type off) {
+    using std::begin;
+    auto first = begin(r);
+    return {std::next(first, off.first), std::next(first, off.second)};
+  }
+
+  constexpr offsets_type offsets() const {
+    using std::begin;
+    auto first = begin(const_cast<Range &>(rng));
+    return {std::distance(first, rgr.first), std::distance(first, rgr.last)};
+  }
 };
 
 /**
  * @brief all(Range &&rng)
  *
- * The `all(Range &&rng)` function takes a range `rng` as input and returns a
- * ranger object. The ranger object represents a range processing operation that
- * can be composed with other ranger operations. The `all` function iterates
- * over the elements in the input range and applies a given function to each
- * element. If the function returns `false` for any element, the iteration stops
- * and `false` is returned. If the function returns `true` for all elements, the
- * iteration continues until all elements have been processed and `true` is
- * returned.
+ * `all` over an rvalue range, which is moved into the returned `all_copy`.
  *
  * @tparam Range
  * @param rng
- * @return std::enable_if<std::is_rvalue_reference<Range &&>::value,
- * all_copy<Range>>::type
+ * @return auto
  */
-template <typename Range>
-typename std::enable_if<std::is_rvalue_reference<Range &&>::value,
-                        all_copy<Range>>::type
-all(Range &&rng) {
-  return all_copy<Range>{std::move(rng)};
+template <typename Range,
+          typename = std::enable_if_t<!std::is_lvalue_reference<Range>::value>,
+          typename = void>
+constexpr auto all(Range &&rng) {
+  return detail::stage("all", all_copy<Range>{std::move(rng)});
 }
 
 // filter
@@ -159,9 +595,10 @@ all(Range &&rng) {
  * @param pred
  * @return auto
  */
-template <typename Pred> auto pred_box(Pred pred) {
-  return
-      [=](auto &&...x) -> int { return pred(std::forward<decltype(x)>(x)...); };
+template <typename Pred> constexpr auto pred_box(Pred pred) {
+  return [pred = std::move(pred)](auto &&...x) -> int {
+    return pred(std::forward<decltype(x)>(x)...);
+  };
 }
 
 /**
@@ -173,14 +610,20 @@ template <typename Pred> auto pred_box(Pred pred) {
  * @param rgr
  * @return auto
  */
-template <typename Pred, typename Ranger> auto filter(Pred pred_, Ranger rgr) {
+template <typename Pred, typename Ranger>
+constexpr auto filter(Pred pred_, Ranger rgr) {
   using cursor = typename Ranger::cursor;
 
-  return ranger<cursor>(
-      [=, pred = pred_box(pred_)](auto dst) TRANSRANGERS_HOT_MUTABLE {
-        return rgr([&](const auto &p)
-                       TRANSRANGERS_HOT { return pred(*p) ? dst(p) : true; });
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<cursor>(
+      hint, [rgr = std::move(rgr), pred = pred_box(std::move(pred_))](
+                auto dst) TRANSRANGERS_HOT_MUTABLE {
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              return pred(*p) ? dst(p) : true;
+            }));
       });
+  return detail::stage("filter", std::move(res), rgr);
 }
 
 /**
@@ -191,7 +634,7 @@ template <typename Pred, typename Ranger> auto filter(Pred pred_, Ranger rgr) {
  * @tparam typename
  */
 template <typename Cursor, typename F, typename = void> struct deref_fun {
-  decltype(auto) operator*() const { return (*pf)(*p); }
+  constexpr decltype(auto) operator*() const { return (*pf)(*p); }
 
   Cursor p;
   F *pf;
@@ -212,13 +655,60 @@ struct deref_fun<
     Cursor, F,
     typename std::enable_if<std::is_trivially_default_constructible<F>::value &&
                             std::is_empty<F>::value>::type> {
-  deref_fun(Cursor p = {}, F * = nullptr) : p{p} {}
+  constexpr deref_fun(Cursor p = {}, F * = nullptr) : p{p} {}
 
-  decltype(auto) operator*() const { return F()(*p); }
+  constexpr decltype(auto) operator*() const { return F()(*p); }
 
   Cursor p;
 };
 
+/**
+ * @brief transform_ranger
+ *
+ * Ranger returned by `transform`. It is sized/random access when `Ranger` is.
+ *
+ * @tparam F
+ * @tparam Ranger
+ */
+template <typename F, typename Ranger> struct transform_ranger {
+  using cursor = deref_fun<typename Ranger::cursor, F>;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    return rgr(
+        detail::exhaustive_like<Dst>([&](const auto &p) TRANSRANGERS_HOT {
+          return dst(cursor{p, &f});
+        }));
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    return rgr.size();
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::has_size_hint_v<R>>>
+  constexpr std::size_t size_hint() const {
+    return detail::size_hint(rgr);
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr cursor at(std::size_t i) {
+    return cursor{rgr.at(i), &f};
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr void advance(std::size_t n) {
+    rgr.advance(n);
+  }
+
+  F f;
+  Ranger rgr;
+};
+
 /**
  * @brief transform
  *
@@ -232,33 +722,38 @@ struct deref_fun<
  * @param rgr
  * @return auto
  */
-template <typename F, typename Ranger> auto transform(F f, Ranger rgr) {
-  using cursor = deref_fun<typename Ranger::cursor, F>;
-
-  return ranger<cursor>([=](auto dst) TRANSRANGERS_HOT_MUTABLE {
-    return rgr([&](const auto &p) TRANSRANGERS_HOT {
-      return dst(cursor{p, &f});
-    });
-  });
+template <typename F, typename Ranger> constexpr auto transform(F f, Ranger rgr) {
+  return detail::stage("transform",
+                       transform_ranger<F, Ranger>{std::move(f), std::move(rgr)},
+                       rgr);
 }
 
 /**
- * @brief take
+ * @brief take_ranger
  *
- * The below code is defining a function template called `take` that takes an
- * integer `n` and a `Ranger` object as arguments. The `Ranger` type is expected
- * to have a nested type called `cursor`.
+ * Ranger returned by `take`. Over a sized ranger, the remaining elements are
+ * compared with `n` once per call: if they all fit, `dst` is passed through
+ * unchanged, and if `rgr` is random access the first `n` elements are run in
+ * a single index loop. Otherwise elements are counted one by one.
  *
  * @tparam Ranger
- * @param n
- * @param rgr
- * @return auto
  */
-template <typename Ranger> auto take(int n, Ranger rgr) {
+template <typename Ranger> struct take_ranger {
   using cursor = typename Ranger::cursor;
 
-  return ranger<cursor>([=](auto dst) TRANSRANGERS_HOT_MUTABLE {
-    if (n)
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if constexpr (detail::sized_ranger_v<Ranger>) {
+      const auto s = rgr.size();
+      if (s <= count()) {
+        auto res = rgr(dst);
+        n -= static_cast<int>(s - rgr.size());
+        return res;
+      }
+      if constexpr (detail::random_access_ranger_v<Ranger>)
+        return detail::run_random_access(*this, count(), dst);
+    }
+    if (n > 0)
       return rgr([&](const auto &p) TRANSRANGERS_HOT {
                --n;
                return dst(p) && (n != 0);
@@ -266,49 +761,333 @@ template <typename Ranger> auto take(int n, Ranger rgr) {
              (n == 0);
     else
       return true;
-  });
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    return (std::min)(count(), rgr.size());
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::has_size_hint_v<R>>>
+  constexpr std::size_t size_hint() const {
+    return (std::min)(count(), detail::size_hint(rgr));
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr cursor at(std::size_t i) {
+    return rgr.at(i);
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr void advance(std::size_t k) {
+    rgr.advance(k);
+    n -= static_cast<int>(k);
+  }
+
+  constexpr std::size_t count() const { return n > 0 ? static_cast<std::size_t>(n) : 0; }
+
+  int n;
+  Ranger rgr;
+};
+
+/**
+ * @brief take
+ *
+ * The below code is defining a function template called `take` that takes an
+ * integer `n` and a `Ranger` object as arguments. The `Ranger` type is expected
+ * to have a nested type called `cursor`.
+ *
+ * @tparam Ranger
+ * @param n
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> constexpr auto take(int n, Ranger rgr) {
+  return detail::stage("take", take_ranger<Ranger>{n, std::move(rgr)}, rgr);
 }
 
 /**
- * @brief
+ * @brief drop_ranger
+ *
+ * Ranger returned by `drop`. Random-access inputs skip the dropped elements
+ * with a single `advance`; other rangers consume them one by one on the
+ * first call.
  *
  * @tparam Ranger
+ */
+template <typename Ranger> struct drop_ranger {
+  using cursor = typename Ranger::cursor;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if (n > 0) {
+      if constexpr (detail::random_access_ranger_v<Ranger>)
+        advance(0);
+      else if (rgr([&](const auto &) { return --n != 0; })) {
+        n = 0;
+        return true;
+      }
+    }
+    return rgr(dst);
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    const auto s = rgr.size();
+    return s > count() ? s - count() : 0;
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr cursor at(std::size_t i) {
+    return rgr.at(count() + i);
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr void advance(std::size_t k) {
+    rgr.advance((std::min)(count() + k, rgr.size()));
+    n = 0;
+  }
+
+  constexpr std::size_t count() const { return n > 0 ? static_cast<std::size_t>(n) : 0; }
+
+  int n;
+  Ranger rgr;
+};
+
+/**
+ * @brief drop
+ *
+ * Returns a ranger over the elements of `rgr` after the first `n` (all of
+ * them if `n <= 0`, none if `rgr` has no more than `n` elements).
+ *
+ * @tparam Ranger
+ * @param n
  * @param rgr
  * @return auto
  */
-template <typename Ranger> auto concat(Ranger rgr) { return rgr; }
+template <typename Ranger> constexpr auto drop(int n, Ranger rgr) {
+  return detail::stage("drop", drop_ranger<Ranger>{n, std::move(rgr)}, rgr);
+}
 
 /**
  * @brief
  *
  * @tparam Ranger
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> constexpr auto concat(Ranger rgr) { return rgr; }
+
+namespace detail {
+
+/* Jump table resuming a concat_ranger at its active input. */
+template <typename Concat, typename Dst, typename Indices> struct concat_table;
+
+template <typename Concat, typename Dst, std::size_t... I>
+struct concat_table<Concat, Dst, std::index_sequence<I...>> {
+  template <std::size_t J> static constexpr bool run(Concat &c, Dst &dst) {
+    return c.template run_from<J>(dst);
+  }
+
+  static constexpr bool (*const entries[])(Concat &, Dst &) = {&run<I>...};
+};
+
+} // namespace detail
+
+/**
+ * @brief concat_ranger
+ *
+ * Ranger returned by `concat`. The inputs are kept side by side in a tuple
+ * along with the index of the active one, from which a call resumes through
+ * a jump table, so resuming costs the same however many inputs there are.
+ * It is sized when all inputs are, and random access when additionally they
+ * share the same cursor type.
+ *
+ * @tparam Rangers
+ */
+template <typename... Rangers> struct concat_ranger {
+  static constexpr std::size_t N = sizeof...(Rangers);
+  using cursor =
+      typename std::tuple_element_t<0, std::tuple<Rangers...>>::cursor;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    return detail::concat_table<concat_ranger, Dst,
+                                std::make_index_sequence<N + 1>>::
+        entries[active](*this, dst);
+  }
+
+  template <std::size_t I, typename Dst>
+  TRANSRANGERS_HOT constexpr bool run_from(Dst &dst) {
+    if constexpr (I < N) {
+      if (!std::get<I>(rgrs)(dst))
+        return false;
+      active = I + 1;
+      return run_from<I + 1>(dst);
+    } else
+      return true;
+  }
+
+  template <bool B = (detail::sized_ranger_v<Rangers> && ...),
+            typename = std::enable_if_t<B>>
+  constexpr std::size_t size() const {
+    return std::apply(
+        [](const auto &...r) { return (std::size_t(0) + ... + r.size()); },
+        rgrs);
+  }
+
+  template <bool B = !(detail::sized_ranger_v<Rangers> && ...) &&
+                     (has_size_hint<Rangers>::value && ...),
+            typename = std::enable_if_t<B>>
+  constexpr std::size_t size_hint() const {
+    return std::apply(
+        [](const auto &...r) {
+          return (std::size_t(0) + ... + detail::size_hint(r));
+        },
+        rgrs);
+  }
+
+  template <bool B = (detail::random_access_ranger_v<Rangers> && ...) &&
+                     (std::is_same<cursor, typename Rangers::cursor>::value &&
+                      ...),
+            typename = std::enable_if_t<B>>
+  constexpr cursor at(std::size_t i) {
+    return at_from<0>(i);
+  }
+
+  template <bool B = (detail::random_access_ranger_v<Rangers> && ...) &&
+                     (std::is_same<cursor, typename Rangers::cursor>::value &&
+                      ...),
+            typename = std::enable_if_t<B>>
+  constexpr void advance(std::size_t k) {
+    std::apply(
+        [&](auto &...r) {
+          auto step = [&](auto &x) {
+            const auto m = (std::min)(k, x.size());
+            x.advance(m);
+            k -= m;
+          };
+          (step(r), ...);
+        },
+        rgrs);
+  }
+
+  std::tuple<Rangers...> rgrs;
+  std::size_t active = 0;
+
+private:
+  template <std::size_t I> constexpr cursor at_from(std::size_t i) {
+    if constexpr (I + 1 == N)
+      return std::get<I>(rgrs).at(i);
+    else {
+      const auto s = std::get<I>(rgrs).size();
+      return i < s ? std::get<I>(rgrs).at(i) : at_from<I + 1>(i - s);
+    }
+  }
+};
+
+/**
+ * @brief concat
+ *
+ * Ranger over the elements of `rgr` followed by those of each of `rgrs` (see
+ * `concat_ranger`).
+ *
+ * @tparam Ranger
  * @tparam Rangers
  * @param rgr
  * @param rgrs
  * @return auto
  */
 template <typename Ranger, typename... Rangers>
-auto concat(Ranger rgr, Rangers... rgrs) {
-  using cursor = typename Ranger::cursor;
+constexpr auto concat(Ranger rgr, Rangers... rgrs) {
+  return detail::stage("concat",
+                       concat_ranger<Ranger, Rangers...>{
+                           std::tuple<Ranger, Rangers...>{std::move(rgr),
+                                                          std::move(rgrs)...}},
+                       rgr, rgrs...);
+}
+
+/**
+ * @brief concat_all_ranger
+ *
+ * Ranger returned by `concat_all` over `Rangers`, a random-access container
+ * of rangers. Resumes at the active ranger, kept by index so that copying or
+ * moving a `concat_all_ranger` is safe.
+ *
+ * @tparam Rangers
+ */
+template <typename Rangers> struct concat_all_ranger {
+  using ranger_type = std::remove_reference_t<
+      decltype(*std::declval<detail::range_iterator_t<Rangers>>())>;
+  using cursor = typename ranger_type::cursor;
+
+  static_assert(!std::is_const<ranger_type>::value,
+                "concat_all needs a container of non-const rangers, as they "
+                "are advanced as their elements are produced");
 
-  return ranger<cursor>([=, cont = false, next = concat(rgrs...)](auto dst)
-                            TRANSRANGERS_HOT_MUTABLE {
-                              if (!cont) {
-                                if (!(cont = rgr(dst)))
-                                  return false;
-                              }
-                              return next(dst);
-                            });
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    using std::begin;
+    using std::end;
+    auto first = begin(rgrs);
+    const auto n = static_cast<std::size_t>(end(rgrs) - first);
+    for (; active < n; ++active)
+      if (!first[static_cast<std::ptrdiff_t>(active)](dst))
+        return false;
+    return true;
+  }
+
+  template <typename R = ranger_type,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    using std::begin;
+    using std::end;
+    std::size_t s = 0;
+    for (auto it = std::next(begin(rgrs), static_cast<std::ptrdiff_t>(active));
+         it != end(rgrs); ++it)
+      s += it->size();
+    return s;
+  }
+
+  Rangers rgrs;
+  std::size_t active = 0;
+};
+
+/**
+ * @brief concat_all
+ *
+ * Ranger over the elements of each of the rangers held in the random-access
+ * container `rgrs` (e.g. a `std::vector` of shards chosen at run time), in
+ * order. Rangers are advanced as they are consumed, so the container is
+ * copied into the returned ranger if an lvalue (leaving the caller's rangers
+ * untouched) and moved if an rvalue. A non-owning container such as a `span`
+ * is copied as such, and still refers to the caller's rangers.
+ *
+ * @tparam Rangers
+ * @param rgrs
+ * @return auto
+ */
+template <typename Rangers> constexpr auto concat_all(Rangers &&rgrs) {
+  return detail::stage(
+      "concat_all",
+      concat_all_ranger<std::decay_t<Rangers>>{std::forward<Rangers>(rgrs)});
 }
-// The above code is implementing a function template called `concat` that
-// concatenates multiple ranges together.
 
 // unique
-template <typename Ranger> auto unique(Ranger rgr) {
+template <typename Ranger> constexpr auto unique(Ranger rgr) {
   using cursor = typename Ranger::cursor;
 
-  return ranger<cursor>(
-      [=, start = true, p = cursor{}](auto dst) TRANSRANGERS_HOT_MUTABLE {
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<cursor>(
+      hint, [rgr = std::move(rgr), start = true,
+             p = cursor{}](auto dst) TRANSRANGERS_HOT_MUTABLE {
         if (start) {
           start = false;
           if (rgr([&](const auto &q) TRANSRANGERS_HOT {
@@ -319,21 +1098,23 @@ template <typename Ranger> auto unique(Ranger rgr) {
           if (!dst(p))
             return false;
         }
-        return rgr([&, prev = p](const auto &q) TRANSRANGERS_HOT_MUTABLE {
-          if ((*prev == *q) || dst(q)) {
-            prev = q;
-            return true;
-          } else {
-            p = q;
-            return false;
-          }
-        });
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&, prev = p](const auto &q) TRANSRANGERS_HOT_MUTABLE {
+              if ((*prev == *q) || dst(q)) {
+                prev = q;
+                return true;
+              } else {
+                p = q;
+                return false;
+              }
+            }));
       });
+  return detail::stage("unique", std::move(res), rgr);
 }
 
 // join
 struct identity_adaption {
-  template <typename T> static decltype(auto) adapt(T &&srgr) {
+  template <typename T> static constexpr decltype(auto) adapt(T &&srgr) {
     return std::forward<decltype(srgr)>(srgr);
   }
 };
@@ -346,25 +1127,35 @@ auto join(Ranger rgr) {
           *std::declval<const cursor &>()))>>;
   using subranger_cursor = typename subranger::cursor;
 
-  return ranger<subranger_cursor>([=, osrgr = std::optional<subranger>{}](
-                                      auto dst) TRANSRANGERS_HOT_MUTABLE {
+  auto res = ranger<subranger_cursor>([rgr = std::move(rgr),
+                                       osrgr = std::optional<subranger>{}](
+                                          auto dst) TRANSRANGERS_HOT_MUTABLE {
     if (osrgr) {
       if (!(*osrgr)(dst))
         return false;
     }
-    return rgr([&](const auto &p) TRANSRANGERS_HOT {
-      auto srgr = Adaption::adapt(*p);
-      if (!srgr(dst)) {
-        osrgr.emplace(std::move(srgr));
-        return false;
-      } else
+    if constexpr (is_exhaustive_consumer<decltype(dst)>::value) {
+      /* dst never stops, so no subranger is ever left half consumed */
+      return rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+        auto srgr = Adaption::adapt(*p);
+        srgr(dst);
         return true;
-    });
+      }));
+    } else
+      return rgr([&](const auto &p) TRANSRANGERS_HOT {
+        auto srgr = Adaption::adapt(*p);
+        if (!srgr(dst)) {
+          osrgr.emplace(std::move(srgr));
+          return false;
+        } else
+          return true;
+      });
   });
+  return detail::stage("join", std::move(res), rgr);
 }
 
 struct all_adaption {
-  template <typename T> static auto adapt(T &&srgn) {
+  template <typename T> static constexpr auto adapt(T &&srgn) {
     return all(std::forward<decltype(srgn)>(srgn));
   }
 };
@@ -372,6 +1163,30 @@ struct all_adaption {
 template <typename Ranger> auto ranger_join(Ranger rgr) {
   return join<Ranger, all_adaption>(std::move(rgr));
 }
+
+/**
+ * @brief join_segments
+ *
+ * Ranger over the subrangers that `join<Ranger, Adaption>` would flatten, so
+ * that downstream stages (e.g. a batched or parallel sink) can process each
+ * segment as a whole, with its own bounds and capabilities (an `all` segment
+ * is random access).
+ *
+ * @tparam Ranger
+ * @tparam Adaption
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger, typename Adaption = identity_adaption>
+constexpr auto join_segments(Ranger rgr) {
+  return transform(
+      [](const auto &x) -> decltype(auto) { return Adaption::adapt(x); },
+      std::move(rgr));
+}
+
+template <typename Ranger> constexpr auto ranger_join_segments(Ranger rgr) {
+  return join_segments<Ranger, all_adaption>(std::move(rgr));
+}
 // The above code defines a function template called `join` that takes a single
 // argument `rgr`. The function template has a default template parameter
 // `Adaption` which is set to `identity_adaption`.
@@ -387,13 +1202,15 @@ template <typename Ranger> auto ranger_join(Ranger rgr) {
  * @tparam Rangers
  */
 template <typename... Rangers> struct zip_cursor {
-  auto operator*() const {
+  using tuple_type = std::tuple<typename Rangers::cursor...>;
+
+  constexpr auto operator*() const {
     return std::apply(
         [](const auto &...ps) { return std::tuple<decltype(*ps)...>{*ps...}; },
         ps);
   }
 
-  std::tuple<typename Rangers::cursor...> ps;
+  tuple_type ps;
 };
 
 // template <typename Ranger, typename... Rangers>
@@ -445,6 +1262,68 @@ template <typename... Rangers> struct zip_cursor {
 //   std::tuple<typename Ranger1::cursor, typename Ranger2::cursor> ps;
 // };
 
+/**
+ * @brief zip2_ranger
+ *
+ * Ranger returned by `zip2`. When both inputs are random access, the common
+ * length is computed once and the pairs are produced in a single index loop;
+ * otherwise `rgr2` is resumed for every element of `rgr1`.
+ *
+ * @tparam Ranger1
+ * @tparam Ranger2
+ */
+template <typename Ranger1, typename Ranger2> struct zip2_ranger {
+  using cursor = zip_cursor<Ranger1, Ranger2>;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if constexpr (detail::random_access_ranger_v<Ranger1> &&
+                  detail::random_access_ranger_v<Ranger2>) {
+      return detail::run_random_access(*this, size(), dst);
+    } else {
+      bool finished = false;
+      return rgr1([&](const auto &p) TRANSRANGERS_HOT {
+               std::get<0>(zp.ps) = p;
+               if (rgr2([&](const auto &p) TRANSRANGERS_HOT {
+                     std::get<1>(zp.ps) = p;
+                     return false;
+                   })) {
+                 finished = true;
+                 return false;
+               }
+               return dst(zp);
+             }) ||
+             finished;
+    }
+  }
+
+  template <typename R = Ranger1,
+            typename = std::enable_if_t<detail::sized_ranger_v<R> &&
+                                        detail::sized_ranger_v<Ranger2>>>
+  constexpr std::size_t size() const {
+    return (std::min)(rgr1.size(), rgr2.size());
+  }
+
+  template <typename R = Ranger1,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R> &&
+                                        detail::random_access_ranger_v<Ranger2>>>
+  constexpr cursor at(std::size_t i) {
+    return cursor{{rgr1.at(i), rgr2.at(i)}};
+  }
+
+  template <typename R = Ranger1,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R> &&
+                                        detail::random_access_ranger_v<Ranger2>>>
+  constexpr void advance(std::size_t n) {
+    rgr1.advance(n);
+    rgr2.advance(n);
+  }
+
+  Ranger1 rgr1;
+  Ranger2 rgr2;
+  cursor zp = {};
+};
+
 /**
  * @brief zip2
  *
@@ -459,24 +1338,177 @@ template <typename... Rangers> struct zip_cursor {
  * @return auto
  */
 template <typename Ranger1, typename Ranger2>
-auto zip2(Ranger1 rgr1, Ranger2 rgr2) {
-  using cursor = zip_cursor<Ranger1, Ranger2>;
+constexpr auto zip2(Ranger1 rgr1, Ranger2 rgr2) {
+  return detail::stage(
+      "zip2", zip2_ranger<Ranger1, Ranger2>{std::move(rgr1), std::move(rgr2)},
+      rgr1, rgr2);
+}
 
-  return ranger<cursor>([=, zp = cursor{}](auto dst) TRANSRANGERS_HOT_MUTABLE {
-    bool finished = false;
-    return rgr1([&](const auto &p) TRANSRANGERS_HOT {
-             std::get<0>(zp.ps) = p;
-             if (rgr2([&](const auto &p) TRANSRANGERS_HOT {
-                   std::get<1>(zp.ps) = p;
-                   return false;
-                 })) {
-               finished = true;
-               return false;
-             }
-             return dst(zp);
-           }) ||
-           finished;
-  });
+// all_columns, project
+
+/**
+ * @brief column_cursor
+ *
+ * Cursor of `all_columns`: one index shared by a set of column pointers
+ * (unlike `zip_cursor`, which keeps one cursor per input). `*p` returns a
+ * `std::tuple` of references to the fields at the index, so only the fields
+ * actually used are loaded. It is a random-access iterator over the rows
+ * (with proxy references).
+ *
+ * @tparam Ts element types of the columns
+ */
+template <typename... Ts> struct column_cursor {
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = std::tuple<std::remove_cv_t<Ts>...>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = std::tuple<Ts &...>;
+
+  constexpr reference operator*() const {
+    return deref(std::index_sequence_for<Ts...>{});
+  }
+  constexpr reference operator[](difference_type n) const {
+    return *(*this + n);
+  }
+  template <std::size_t I> constexpr auto &column() const {
+    return std::get<I>(cols)[i];
+  }
+
+  constexpr column_cursor &operator++() {
+    ++i;
+    return *this;
+  }
+  constexpr column_cursor operator++(int) {
+    auto tmp = *this;
+    ++i;
+    return tmp;
+  }
+  constexpr column_cursor &operator--() {
+    --i;
+    return *this;
+  }
+  constexpr column_cursor operator--(int) {
+    auto tmp = *this;
+    --i;
+    return tmp;
+  }
+  constexpr column_cursor &operator+=(difference_type n) {
+    i += static_cast<std::size_t>(n);
+    return *this;
+  }
+  constexpr column_cursor &operator-=(difference_type n) {
+    i -= static_cast<std::size_t>(n);
+    return *this;
+  }
+  constexpr column_cursor operator+(difference_type n) const {
+    return {cols, i + static_cast<std::size_t>(n)};
+  }
+  friend constexpr column_cursor operator+(difference_type n,
+                                           const column_cursor &p) {
+    return p + n;
+  }
+  constexpr column_cursor operator-(difference_type n) const {
+    return {cols, i - static_cast<std::size_t>(n)};
+  }
+  constexpr difference_type operator-(const column_cursor &p) const {
+    return static_cast<difference_type>(i - p.i);
+  }
+
+  constexpr bool operator==(const column_cursor &p) const { return i == p.i; }
+  constexpr bool operator!=(const column_cursor &p) const { return i != p.i; }
+  constexpr bool operator<(const column_cursor &p) const { return i < p.i; }
+  constexpr bool operator>(const column_cursor &p) const { return i > p.i; }
+  constexpr bool operator<=(const column_cursor &p) const { return i <= p.i; }
+  constexpr bool operator>=(const column_cursor &p) const { return i >= p.i; }
+
+  template <std::size_t... I>
+  constexpr reference deref(std::index_sequence<I...>) const {
+    return reference{std::get<I>(cols)[i]...};
+  }
+
+  std::tuple<Ts *...> cols;
+  std::size_t i;
+};
+
+/**
+ * @brief all_columns
+ *
+ * Ranger over the rows of a struct-of-arrays table: the `n`-th element is
+ * the tuple of references to the `n`-th elements of `cols`, which must be
+ * contiguous ranges (`std::vector`, `std::array`, C arrays...) and are
+ * truncated to the shortest one. The result is an `all_ranger` of
+ * `column_cursor`s, hence sized, random access and batched under
+ * `TRANSRANGERS_BATCH_WIDTH`. Use `project` to work on some of the fields.
+ *
+ * @tparam Columns
+ * @param cols
+ * @return auto
+ */
+template <typename... Columns>
+constexpr auto all_columns(Columns &...cols) {
+  static_assert(sizeof...(Columns) > 0, "all_columns requires some column");
+  using std::data;
+  using std::size;
+  using cursor = column_cursor<std::remove_reference_t<decltype(*data(cols))>...>;
+
+  const auto n = (std::min)({static_cast<std::size_t>(size(cols))...});
+  const auto ps = std::make_tuple(data(cols)...);
+  return detail::stage("all_columns", all_ranger<cursor>{{ps, 0}, {ps, n}});
+}
+
+namespace detail {
+
+/* std::get<I>(x), by value when x is an rvalue owning its members */
+template <std::size_t I, typename Tuple>
+constexpr decltype(auto) member(Tuple &&x) {
+  using type = decltype(std::get<I>(std::forward<Tuple>(x)));
+  if constexpr (std::is_rvalue_reference<type>::value)
+    return std::remove_reference_t<type>(std::get<I>(std::forward<Tuple>(x)));
+  else
+    return std::get<I>(std::forward<Tuple>(x));
+}
+
+template <typename F, std::size_t... I> struct projection {
+  template <typename Tuple> constexpr decltype(auto) operator()(Tuple &&x) const {
+    return f(member<I>(std::forward<Tuple>(x))...);
+  }
+
+  F f;
+};
+
+template <std::size_t... I> struct fields {
+  template <typename Tuple> constexpr decltype(auto) operator()(Tuple &&x) const {
+    if constexpr (sizeof...(I) == 1)
+      return member<I...>(std::forward<Tuple>(x));
+    else
+      return std::tuple<decltype(member<I>(std::forward<Tuple>(x)))...>{
+          member<I>(std::forward<Tuple>(x))...};
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief project
+ *
+ * Returns a function object calling `f` with fields `I...` of its tuple-like
+ * argument, e.g. `filter(project<2>(pred), all_columns(a, b, c))` reads only
+ * column `c` to test rows and `transform(project<0, 1>(f), ...)` passes
+ * `a[n]` and `b[n]` to `f`. Without `f`, the function object returns field
+ * `I` (by reference when the argument holds references, as
+ * `column_cursor::reference` does) or a tuple of fields `I...`.
+ *
+ * @tparam I
+ * @tparam F
+ * @param f
+ * @return auto
+ */
+template <std::size_t... I, typename F> constexpr auto project(F f) {
+  return detail::projection<F, I...>{std::move(f)};
+}
+
+template <std::size_t... I> constexpr auto project() {
+  return detail::fields<I...>{};
 }
 
 // accumulate
@@ -493,11 +1525,12 @@ auto zip2(Ranger1 rgr1, Ranger2 rgr2) {
  * @param init
  * @return T
  */
-template <typename Ranger, typename T> T accumulate(Ranger rgr, T init) {
-  rgr([&](const auto &p) TRANSRANGERS_HOT {
+template <typename Ranger, typename T>
+constexpr T accumulate(Ranger rgr, T init) {
+  rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
     init = std::move(init) + *p;
     return true;
-  });
+  }));
   return init;
 }
 
@@ -505,4 +1538,8 @@ template <typename Ranger, typename T> T accumulate(Ranger rgr, T init) {
 
 #undef TRANSRANGERS_HOT_MUTABLE
 #undef TRANSRANGERS_HOT
+
+#if defined(TRANSRANGERS_PROFILE)
+#include "transrangers_profile.hpp"
+#endif
 #endif
@@ -0,0 +1,290 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_ANY_HPP
+#define JOAQUINTIDES_TRANSRANGERS_ANY_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "transrangers.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
+/* Size of the in-place storage of any_ranger; larger rangers, and those that
+ * can throw on move, are allocated on the heap.
+ */
+#if !defined(TRANSRANGERS_ANY_BUFFER_SIZE)
+#define TRANSRANGERS_ANY_BUFFER_SIZE 64
+#endif
+
+namespace transrangers {
+
+namespace detail::any {
+
+struct storage {
+  union {
+    alignas(std::max_align_t) unsigned char buffer[TRANSRANGERS_ANY_BUFFER_SIZE];
+    void *heap;
+  };
+};
+
+template <typename T> struct vtable {
+  /* constructs up to cap elements at out, counted in n as they are built
+   * (so they can be destroyed if the ranger or a constructor throws),
+   * returns true if done
+   */
+  bool (*pull)(storage &, T *out, std::size_t cap, std::size_t &n);
+  void (*copy)(const storage &, storage &);
+  void (*move)(storage &, storage &) noexcept;
+  void (*destroy)(storage &) noexcept;
+};
+
+template <typename T, typename Ranger> struct model {
+  static constexpr bool in_place =
+      sizeof(Ranger) <= sizeof(storage::buffer) &&
+      alignof(Ranger) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible<Ranger>::value;
+
+  static Ranger &get(storage &s) {
+    if constexpr (in_place)
+      return *std::launder(reinterpret_cast<Ranger *>(s.buffer));
+    else
+      return *static_cast<Ranger *>(s.heap);
+  }
+  static const Ranger &get(const storage &s) {
+    return get(const_cast<storage &>(s));
+  }
+
+  static void construct(storage &s, Ranger &&rgr) {
+    if constexpr (in_place)
+      ::new (static_cast<void *>(s.buffer)) Ranger(std::move(rgr));
+    else
+      s.heap = new Ranger(std::move(rgr));
+  }
+
+  static bool pull(storage &s, T *out, std::size_t cap, std::size_t &n) {
+    n = 0;
+    return get(s)([&](const auto &p) TRANSRANGERS_HOT {
+      ::new (static_cast<void *>(out + n)) T(*p);
+      return ++n != cap;
+    });
+  }
+
+  static void copy(const storage &src, storage &dst) {
+    if constexpr (in_place)
+      ::new (static_cast<void *>(dst.buffer)) Ranger(get(src));
+    else
+      dst.heap = new Ranger(get(src));
+  }
+
+  static void move(storage &src, storage &dst) noexcept {
+    if constexpr (in_place) {
+      ::new (static_cast<void *>(dst.buffer)) Ranger(std::move(get(src)));
+      get(src).~Ranger();
+    } else
+      dst.heap = src.heap;
+  }
+
+  static void destroy(storage &s) noexcept {
+    if constexpr (in_place)
+      get(s).~Ranger();
+    else
+      delete static_cast<Ranger *>(s.heap);
+  }
+
+  static constexpr vtable<T> table = {&pull, &copy, &move, &destroy};
+};
+
+} // namespace detail::any
+
+/**
+ * @brief any_ranger
+ *
+ * Type-erased ranger producing elements convertible to `T`, for pipelines
+ * whose shape is only known at run time. The wrapped ranger is stored in
+ * place if it fits in TRANSRANGERS_ANY_BUFFER_SIZE bytes (on the heap
+ * otherwise) and is invoked once per chunk of up to `Chunk` elements, which
+ * are copied into a buffer inside the `any_ranger` and fed to the consumer
+ * from there, as batches if the consumer accepts them. So the cost of the
+ * indirection is one indirect call per chunk rather than per element.
+ * Cursors are `const T*` into the buffer and remain valid until the
+ * `any_ranger` is resumed. If the wrapped ranger pauses without producing
+ * any element (a stalled `tee_ranger`, an `async_source_ranger` waiting for
+ * data), the `any_ranger` returns `false` as well.
+ *
+ * @tparam T
+ * @tparam Chunk
+ */
+template <typename T, std::size_t Chunk = 64> class any_ranger {
+  static_assert(Chunk > 0);
+
+public:
+  using cursor = const T *;
+
+  /* empty range */
+  any_ranger() = default;
+
+  template <typename Ranger,
+            typename = std::enable_if_t<
+                !std::is_same<std::decay_t<Ranger>, any_ranger>::value>>
+  any_ranger(Ranger rgr)
+      : vt{&detail::any::model<T, Ranger>::table}, done{false} {
+    detail::any::model<T, Ranger>::construct(rgr_storage, std::move(rgr));
+  }
+
+  any_ranger(const any_ranger &x) : vt{x.vt}, done{x.done} {
+    if (vt)
+      vt->copy(x.rgr_storage, rgr_storage);
+    try {
+      for (; n < x.n - x.pos; ++n)
+        ::new (static_cast<void *>(data() + n)) T(x.data()[x.pos + n]);
+    } catch (...) {
+      reset();
+      throw;
+    }
+  }
+
+  any_ranger(any_ranger &&x) noexcept(
+      std::is_nothrow_move_constructible<T>::value) {
+    take(x);
+  }
+
+  /* x is copied before *this is released, so *this is unchanged if copying
+   * throws. If moving the copy in then throws (only for T without a
+   * nothrow move constructor), *this is left empty.
+   */
+  any_ranger &operator=(const any_ranger &x) {
+    if (this != &x) {
+      any_ranger tmp{x};
+      reset();
+      take(tmp);
+    }
+    return *this;
+  }
+
+  any_ranger &operator=(any_ranger &&x) noexcept(
+      std::is_nothrow_move_constructible<T>::value) {
+    if (this != &x) {
+      reset();
+      take(x);
+    }
+    return *this;
+  }
+
+  ~any_ranger() { reset(); }
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    for (;;) {
+      if constexpr (is_batch_consumer<Dst>::value) {
+        constexpr auto W = Dst::batch_width;
+        while (n - pos >= W) {
+          span_batch<cursor, W> b{data() + pos};
+          pos += W;
+          if (!dst(b))
+            return false;
+        }
+      }
+      for (auto it = data() + pos, last = data() + n; it != last;) {
+        cursor p = it++;
+        if (!dst(p)) {
+          pos = static_cast<std::size_t>(it - data());
+          return false;
+        }
+      }
+      pos = n;
+      if (done)
+        return true;
+      clear();
+      done = vt->pull(rgr_storage, data(), Chunk, n);
+      if (n == 0 && !done)
+        return false; /* the wrapped ranger paused (e.g. a stalled tee) */
+    }
+  }
+
+private:
+  T *data() { return std::launder(reinterpret_cast<T *>(elements)); }
+  const T *data() const {
+    return std::launder(reinterpret_cast<const T *>(elements));
+  }
+
+  void clear() noexcept {
+    for (auto p = data(), last = p + n; p != last; ++p)
+      p->~T();
+    n = pos = 0;
+  }
+
+  /* leaves *this empty */
+  void reset() noexcept {
+    clear();
+    if (vt) {
+      vt->destroy(rgr_storage);
+      vt = nullptr;
+    }
+    done = true;
+  }
+
+  /* moves the contents of x into *this, which must be empty; x is left
+   * empty, and so is *this if moving an element throws
+   */
+  void take(any_ranger &x) noexcept(
+      std::is_nothrow_move_constructible<T>::value) {
+    vt = x.vt;
+    done = x.done;
+    if (vt) {
+      vt->move(x.rgr_storage, rgr_storage);
+      x.vt = nullptr;
+    }
+    auto move_elements = [&] {
+      for (; n < x.n - x.pos; ++n)
+        ::new (static_cast<void *>(data() + n))
+            T(std::move(x.data()[x.pos + n]));
+    };
+    if constexpr (std::is_nothrow_move_constructible<T>::value)
+      move_elements();
+    else {
+      try {
+        move_elements();
+      } catch (...) {
+        reset();
+        x.reset();
+        throw;
+      }
+    }
+    x.reset();
+  }
+
+  const detail::any::vtable<T> *vt = nullptr;
+  detail::any::storage rgr_storage;
+  bool done = true;
+  std::size_t n = 0, pos = 0; /* buffered elements, next one to feed */
+  alignas(T) unsigned char elements[Chunk * sizeof(T)];
+};
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
+#endif
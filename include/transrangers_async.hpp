@@ -0,0 +1,352 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_ASYNC_HPP
+#define JOAQUINTIDES_TRANSRANGERS_ASYNC_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/* Requires C++20 coroutines; empty otherwise. */
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "transrangers.hpp"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
+namespace transrangers {
+
+/**
+ * @brief task
+ *
+ * Lazily started coroutine producing a `T`, resumed by `co_await`ing it (its
+ * awaiter is resumed when it completes) or run to completion with
+ * `sync_wait`.
+ *
+ * @tparam T
+ */
+template <typename T> class task {
+public:
+  struct promise_type {
+    struct final_awaiter {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+        auto c = h.promise().continuation;
+        return c ? c : std::noop_coroutine();
+      }
+      void await_resume() const noexcept {}
+    };
+
+    task get_return_object() {
+      return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter final_suspend() const noexcept { return {}; }
+    void return_value(T x) { value.emplace(std::move(x)); }
+    void unhandled_exception() { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::optional<T> value;
+    std::exception_ptr error;
+  };
+
+  task(task &&x) noexcept : h{std::exchange(x.h, {})} {}
+  task &operator=(task &&) = delete;
+  ~task() {
+    if (h)
+      h.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> c) noexcept {
+    h.promise().continuation = c;
+    return h;
+  }
+  T await_resume() {
+    if (h.promise().error)
+      std::rethrow_exception(h.promise().error);
+    return std::move(*h.promise().value);
+  }
+
+private:
+  explicit task(std::coroutine_handle<promise_type> h) : h{h} {}
+
+  std::coroutine_handle<promise_type> h;
+};
+
+namespace detail::async {
+
+struct detached {
+  struct promise_type {
+    detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+template <typename T> struct wait_state {
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool done = false;
+  std::optional<T> value;
+  std::exception_ptr error;
+};
+
+template <typename T> detached run(task<T> &t, wait_state<T> &s) {
+  try {
+    s.value.emplace(co_await t);
+  } catch (...) {
+    s.error = std::current_exception();
+  }
+  std::lock_guard<std::mutex> lk{s.mtx};
+  s.done = true;
+  s.cv.notify_one();
+}
+
+} // namespace detail::async
+
+/**
+ * @brief sync_wait
+ *
+ * Runs `t` and blocks the calling thread until it completes, possibly
+ * resumed from another thread.
+ *
+ * @tparam T
+ * @param t
+ * @return T
+ */
+template <typename T> T sync_wait(task<T> t) {
+  detail::async::wait_state<T> s;
+  detail::async::run(t, s);
+  std::unique_lock<std::mutex> lk{s.mtx};
+  s.cv.wait(lk, [&] { return s.done; });
+  if (s.error)
+    std::rethrow_exception(s.error);
+  return std::move(*s.value);
+}
+
+/**
+ * @brief async_channel
+ *
+ * Bounded multi-producer, single-consumer queue usable as an async source:
+ * `co_await ch.read(buf)` replaces the contents of `buf` with the queued
+ * elements, suspending the reading coroutine while the queue is empty; a
+ * suspended reader is resumed by the next `push` or `close`, on the thread
+ * calling it. `push` blocks while the queue holds `capacity` elements, which
+ * propagates backpressure to the producers.
+ *
+ * @tparam T
+ */
+template <typename T> class async_channel {
+  struct read_awaiter {
+    bool await_ready() const {
+      std::lock_guard<std::mutex> lk{ch->mtx};
+      return !ch->q.empty() || ch->closed;
+    }
+    bool await_suspend(std::coroutine_handle<> h) const {
+      std::lock_guard<std::mutex> lk{ch->mtx};
+      if (!ch->q.empty() || ch->closed)
+        return false;
+      ch->reader = h;
+      return true;
+    }
+    /* false if the stream ended (buf holds its last elements, if any) */
+    bool await_resume() const {
+      std::unique_lock<std::mutex> lk{ch->mtx};
+      buf->clear();
+      for (; !ch->q.empty(); ch->q.pop_front())
+        buf->push_back(std::move(ch->q.front()));
+      auto more = !ch->closed;
+      lk.unlock();
+      ch->not_full.notify_all();
+      return more;
+    }
+
+    async_channel *ch;
+    std::vector<T> *buf;
+  };
+
+public:
+  using value_type = T;
+
+  explicit async_channel(std::size_t capacity = 1024) : capacity{capacity} {}
+
+  void push(T x) {
+    std::unique_lock<std::mutex> lk{mtx};
+    not_full.wait(lk, [&] { return q.size() < capacity; });
+    q.push_back(std::move(x));
+    wake(lk);
+  }
+
+  bool try_push(T x) {
+    std::unique_lock<std::mutex> lk{mtx};
+    if (q.size() >= capacity)
+      return false;
+    q.push_back(std::move(x));
+    wake(lk);
+    return true;
+  }
+
+  void close() {
+    std::unique_lock<std::mutex> lk{mtx};
+    closed = true;
+    wake(lk);
+  }
+
+  read_awaiter read(std::vector<T> &buf) { return {this, &buf}; }
+
+private:
+  void wake(std::unique_lock<std::mutex> &lk) {
+    auto h = std::exchange(reader, {});
+    lk.unlock();
+    if (h)
+      h.resume();
+  }
+
+  std::mutex mtx;
+  std::condition_variable not_full;
+  std::deque<T> q;
+  std::size_t capacity;
+  bool closed = false;
+  std::coroutine_handle<> reader;
+};
+
+namespace detail::async {
+
+template <typename T> struct source_state {
+  std::vector<T> buf;
+  std::size_t pos = 0;
+  bool eof = false, starved = false;
+};
+
+} // namespace detail::async
+
+/**
+ * @brief async_source_ranger
+ *
+ * Ranger over the elements read so far from an async source, handed by
+ * `co_for_each` and `co_accumulate` to the user-supplied pipeline. When the
+ * buffered elements run out before the end of the stream it returns `false`
+ * without its consumer having stopped; the driving coroutine then awaits more
+ * data and resumes the pipeline. This suits transrangers that pass `false` on
+ * from their input and resume later (`filter`, `transform`, `take`, `drop`,
+ * `concat`, `join`, `enumerate`, `group_reduce`, `distinct`, the scans) but
+ * not those that read their input ahead one element at a time (`unique`,
+ * `zip`, `zip2`, the build side of `hash_join`).
+ *
+ * @tparam T
+ */
+template <typename T> struct async_source_ranger {
+  using cursor = T *;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    auto &s = *st;
+    auto first = s.buf.data() + s.pos, last = s.buf.data() + s.buf.size();
+    if constexpr (is_batch_consumer<Dst>::value) {
+      constexpr auto W = Dst::batch_width;
+      while (static_cast<std::size_t>(last - first) >= W) {
+        auto b = span_batch<cursor, W>{first};
+        first += W;
+        if (!dst(b)) {
+          s.pos = static_cast<std::size_t>(first - s.buf.data());
+          return false;
+        }
+      }
+    }
+    while (first != last)
+      if (!dst(first++)) {
+        s.pos = static_cast<std::size_t>(first - s.buf.data());
+        return false;
+      }
+    s.pos = s.buf.size();
+    if (s.eof)
+      return true;
+    s.starved = true;
+    return false;
+  }
+
+  detail::async::source_state<T> *st;
+};
+
+/**
+ * @brief co_for_each
+ *
+ * Coroutine feeding the cursors of `pipeline(rgr)`, with `rgr` the
+ * `async_source_ranger` over `src`, to `dst`. `src` is read from only when
+ * the pipeline has consumed the previous batch: `co_await src.read(buf)`
+ * must replace the contents of `buf` with the next elements and return
+ * `false` at the end of the stream (see `async_channel`); sockets or
+ * `io_uring` completions can be wrapped the same way. Elements read but not
+ * consumed when `dst` stops are dropped.
+ *
+ * @tparam Source
+ * @tparam Pipeline
+ * @tparam Dst
+ * @param src
+ * @param pipeline callable mapping the source ranger to the final ranger
+ * @param dst
+ * @return task<bool>, `false` if `dst` stopped before the end of the stream
+ */
+template <typename Source, typename Pipeline, typename Dst>
+task<bool> co_for_each(Source &src, Pipeline pipeline, Dst dst) {
+  using value_type = typename Source::value_type;
+
+  detail::async::source_state<value_type> st;
+  auto rgr = pipeline(async_source_ranger<value_type>{&st});
+  for (;;) {
+    st.starved = false;
+    if (rgr(dst))
+      co_return true;
+    if (!st.starved)
+      co_return false;
+    st.pos = 0;
+    st.eof = !co_await src.read(st.buf);
+  }
+}
+
+template <typename Source, typename Pipeline, typename T>
+task<T> co_accumulate(Source &src, Pipeline pipeline, T init) {
+  co_await co_for_each(src, std::move(pipeline),
+                       [&](const auto &p) TRANSRANGERS_HOT {
+                         init = std::move(init) + *p;
+                         return true;
+                       });
+  co_return init;
+}
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
+#endif
+#endif
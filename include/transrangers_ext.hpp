@@ -17,6 +17,23 @@
 
 #include "transrangers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+
 #if defined(__clang__)
 #define TRANSRANGERS_HOT __attribute__((flatten))
 #define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
@@ -28,173 +45,2476 @@
 #define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
 #endif
 
-namespace transrangers {
+namespace transrangers {
+
+namespace detail {
+
+/* std::next/std::prev by up to n, stopping at the other end */
+template <typename Iterator>
+Iterator clamped_next(Iterator first, Iterator last, std::size_t n) {
+  if constexpr (std::is_base_of<std::random_access_iterator_tag,
+                                typename std::iterator_traits<
+                                    Iterator>::iterator_category>::value)
+    return first + static_cast<std::ptrdiff_t>((std::min)(
+                       n, static_cast<std::size_t>(last - first)));
+  else {
+    for (; n != 0 && first != last; --n)
+      ++first;
+    return first;
+  }
+}
+
+template <typename Iterator>
+Iterator clamped_prev(Iterator first, Iterator last, std::size_t n) {
+  if constexpr (std::is_base_of<std::random_access_iterator_tag,
+                                typename std::iterator_traits<
+                                    Iterator>::iterator_category>::value)
+    return last - static_cast<std::ptrdiff_t>((std::min)(
+                      n, static_cast<std::size_t>(last - first)));
+  else {
+    for (; n != 0 && last != first; --n)
+      --last;
+    return last;
+  }
+}
+
+} // namespace detail
+
+// skip_first, skip_first_copy
+
+/**
+ * @brief skip_first
+ *
+ * The `skip_first` function is a part of the Transrangers library, which
+ * provides an efficient and composable design pattern for range processing.
+ * It returns an `all_ranger` with the first `n` elements of `rng` skipped
+ * (empty if `rng` has no more than `n`), so the result is random access when
+ * `rng` is. For neighbor access (stencils) see `adjacent`.
+ *
+ * @tparam Range
+ * @param rng
+ * @param n
+ * @return auto
+ */
+template <typename Range,
+          typename = std::enable_if_t<std::is_lvalue_reference<Range>::value>>
+auto skip_first(Range &&rng, std::size_t n = 1) {
+  using std::begin;
+  using std::end;
+  using cursor = decltype(begin(rng));
+
+  auto last = end(rng);
+  return all_ranger<cursor>{detail::clamped_next(begin(rng), last, n), last};
+}
+
+/**
+ * @brief skip_first_copy
+ *
+ * `skip_first` over an rvalue range, owned as in `all_copy`.
+ *
+ * @tparam Range
+ */
+template <typename Range> struct skip_first_copy : all_copy<Range> {
+  skip_first_copy(Range &&rng, std::size_t n)
+      : all_copy<Range>(std::move(rng),
+                        [n](Range &r) { return skip_first(r, n); }) {}
+};
+
+template <typename Range,
+          typename = std::enable_if_t<!std::is_lvalue_reference<Range>::value>,
+          typename = void>
+auto skip_first(Range &&rng, std::size_t n = 1) {
+  return skip_first_copy<Range>{std::move(rng), n};
+}
+
+// skip_last, skip_last_copy
+template <typename Range,
+          typename = std::enable_if_t<std::is_lvalue_reference<Range>::value>>
+auto skip_last(Range &&rng, std::size_t n = 1) {
+  using std::begin;
+  using std::end;
+  using cursor = decltype(begin(rng));
+
+  auto first = begin(rng);
+  return all_ranger<cursor>{first, detail::clamped_prev(first, end(rng), n)};
+}
+
+template <typename Range> struct skip_last_copy : all_copy<Range> {
+  skip_last_copy(Range &&rng, std::size_t n)
+      : all_copy<Range>(std::move(rng),
+                        [n](Range &r) { return skip_last(r, n); }) {}
+};
+
+template <typename Range,
+          typename = std::enable_if_t<!std::is_lvalue_reference<Range>::value>,
+          typename = void>
+auto skip_last(Range &&rng, std::size_t n = 1) {
+  return skip_last_copy<Range>{std::move(rng), n};
+}
+
+// skip_both, skip_both_copy
+template <typename Range,
+          typename = std::enable_if_t<std::is_lvalue_reference<Range>::value>>
+auto skip_both(Range &&rng, std::size_t n = 1) {
+  using std::begin;
+  using std::end;
+  using cursor = decltype(begin(rng));
+
+  auto first = detail::clamped_next(begin(rng), end(rng), n);
+  return all_ranger<cursor>{first, detail::clamped_prev(first, end(rng), n)};
+}
+
+template <typename Range> struct skip_both_copy : all_copy<Range> {
+  skip_both_copy(Range &&rng, std::size_t n)
+      : all_copy<Range>(std::move(rng),
+                        [n](Range &r) { return skip_both(r, n); }) {}
+};
+
+template <typename Range,
+          typename = std::enable_if_t<!std::is_lvalue_reference<Range>::value>,
+          typename = void>
+auto skip_both(Range &&rng, std::size_t n = 1) {
+  return skip_both_copy<Range>{std::move(rng), n};
+}
+
+/**
+ * @brief enumerate_cursor
+ *
+ * Cursor of `enumerate`: dereferences to a `std::pair` of the index and the
+ * element of the underlying cursor as returned by `*p` (a reference for
+ * `all`), so elements are not copied.
+ *
+ * @tparam Cursor
+ */
+template <typename Cursor> struct enumerate_cursor {
+  constexpr auto operator*() const {
+    return std::pair<std::size_t, decltype(*p)>{i, *p};
+  }
+
+  std::size_t i;
+  Cursor p;
+};
+
+/**
+ * @brief enumerate_ranger
+ *
+ * Ranger returned by `enumerate`. The index of the next element is kept in
+ * the ranger, so it carries on across resumptions. Sized and random access
+ * when `Ranger` is.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger> struct enumerate_ranger {
+  using cursor = enumerate_cursor<typename Ranger::cursor>;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if constexpr (detail::random_access_ranger_v<Ranger>)
+      return detail::run_random_access(*this, size(), dst);
+    else
+      return rgr(detail::exhaustive_like<Dst>(
+          [&](const auto &p) TRANSRANGERS_HOT { return dst(cursor{index++, p}); }));
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    return rgr.size();
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<!detail::sized_ranger_v<R> &&
+                                        has_size_hint<R>::value>>
+  constexpr std::size_t size_hint() const {
+    return rgr.size_hint();
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr cursor at(std::size_t i) {
+    return {index + i, rgr.at(i)};
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr void advance(std::size_t n) {
+    rgr.advance(n);
+    index += n;
+  }
+
+  Ranger rgr;
+  std::size_t index = 0;
+};
+
+/**
+ * @brief Enumerate
+ *
+ * The `enumerate` function is a part of the Transrangers library. It takes a
+ * range `rgr` as input and returns a new range where each element is paired
+ * with its corresponding index (see `enumerate_cursor`).
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> constexpr auto enumerate(Ranger rgr) {
+  return detail::stage("enumerate", enumerate_ranger<Ranger>{std::move(rgr)},
+                       rgr);
+}
+
+// adjacent, stride, sliding_window
+
+/**
+ * @brief adjacent_cursor
+ *
+ * Cursor of `adjacent<N>`: holds the last `N` cursors of the underlying
+ * ranger, oldest first, and dereferences to a `std::tuple` of what they
+ * dereference to, so `auto [prev, x, next] = *p;` gives neighbor access
+ * without copying elements.
+ *
+ * @tparam Cursor
+ * @tparam N
+ */
+template <typename Cursor, std::size_t N> struct adjacent_cursor {
+  constexpr auto operator*() const {
+    return deref(std::make_index_sequence<N>{});
+  }
+
+  template <std::size_t... I>
+  constexpr auto deref(std::index_sequence<I...>) const {
+    return std::tuple<decltype(*ps[I])...>{*ps[I]...};
+  }
+
+  std::array<Cursor, N> ps;
+};
+
+/**
+ * @brief adjacent_ranger
+ *
+ * Ranger returned by `adjacent<N>`. The `N - 1` cursors preceding the next
+ * element are kept in the ranger (as `unique` keeps one), so it carries on
+ * across resumptions; cursors of `Ranger` must stay valid after it has moved
+ * past them. Sized and random access when `Ranger` is: the window at index
+ * `i` is then read with `rgr.at(i)`...`rgr.at(i + N - 1)`, which lets
+ * stencils over contiguous data vectorize.
+ *
+ * @tparam N
+ * @tparam Ranger
+ */
+template <std::size_t N, typename Ranger> struct adjacent_ranger {
+  static_assert(N > 0, "adjacent requires N > 0");
+  using cursor = adjacent_cursor<typename Ranger::cursor, N>;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if constexpr (detail::random_access_ranger_v<Ranger>)
+      return detail::run_random_access(*this, size(), dst);
+    else {
+      if (filled < N - 1) {
+        if (rgr([&](const auto &p) TRANSRANGERS_HOT {
+              shift_in(p);
+              return ++filled < N - 1;
+            }))
+          return true;
+        if (filled < N - 1)
+          return false;
+      }
+      return rgr(
+          detail::exhaustive_like<Dst>([&](const auto &p) TRANSRANGERS_HOT {
+            shift_in(p);
+            return dst(static_cast<const cursor &>(c));
+          }));
+    }
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    const auto s = rgr.size() + filled;
+    return s >= N - 1 ? s - (N - 1) : 0;
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<!detail::sized_ranger_v<R> &&
+                                        has_size_hint<R>::value>>
+  constexpr std::size_t size_hint() const {
+    const auto s = rgr.size_hint() + filled;
+    return s >= N - 1 ? s - (N - 1) : 0;
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr cursor at(std::size_t i) {
+    cursor res{};
+    for (std::size_t m = 0; m < N; ++m)
+      res.ps[m] = element(i + m);
+    return res;
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr void advance(std::size_t k) {
+    if (k == 0)
+      return;
+    cursor res{}; /* the N - 1 elements preceding window k */
+    for (std::size_t m = 1; m < N; ++m)
+      res.ps[m] = element(k + m - 1);
+    rgr.advance(k + (N - 1) - filled);
+    c = res;
+    filled = N - 1;
+  }
+
+  constexpr void shift_in(const typename Ranger::cursor &p) {
+    for (std::size_t m = 1; m < N; ++m)
+      c.ps[m - 1] = c.ps[m];
+    c.ps[N - 1] = p;
+  }
+
+  /* i-th element from the first one kept (c.ps[N - filled]) */
+  constexpr typename Ranger::cursor element(std::size_t i) {
+    return i < filled ? c.ps[N - filled + i] : rgr.at(i - filled);
+  }
+
+  Ranger rgr;
+  cursor c{};
+  std::size_t filled = 0;
+};
+
+/**
+ * @brief adjacent
+ *
+ * Returns a ranger over the windows of `N` consecutive elements of `rgr`
+ * (`rgr` having `n` elements, `n - N + 1` windows, or none if `n < N`) in a
+ * single pass (see `adjacent_ranger`).
+ *
+ * @tparam N
+ * @tparam Ranger
+ * @param rgr
+ * @return auto
+ */
+template <std::size_t N, typename Ranger> constexpr auto adjacent(Ranger rgr) {
+  return detail::stage("adjacent", adjacent_ranger<N, Ranger>{std::move(rgr)},
+                       rgr);
+}
+
+/**
+ * @brief stride_ranger
+ *
+ * Ranger returned by `stride`. Random-access inputs are read directly at
+ * `rgr.at(skip + i * n)`; other rangers are run through, counting down the
+ * elements to skip before the next one.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger> struct stride_ranger {
+  using cursor = typename Ranger::cursor;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if constexpr (detail::random_access_ranger_v<Ranger>)
+      return detail::run_random_access(*this, size(), dst);
+    else
+      return rgr(
+          detail::exhaustive_like<Dst>([&](const auto &p) TRANSRANGERS_HOT {
+            if (skip != 0) {
+              --skip;
+              return true;
+            }
+            skip = n - 1;
+            return dst(p);
+          }));
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::sized_ranger_v<R>>>
+  constexpr std::size_t size() const {
+    return strided(rgr.size());
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<!detail::sized_ranger_v<R> &&
+                                        has_size_hint<R>::value>>
+  constexpr std::size_t size_hint() const {
+    return strided(rgr.size_hint());
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr cursor at(std::size_t i) {
+    return rgr.at(skip + i * n);
+  }
+
+  template <typename R = Ranger,
+            typename = std::enable_if_t<detail::random_access_ranger_v<R>>>
+  constexpr void advance(std::size_t k) {
+    if (k == 0)
+      return;
+    rgr.advance((std::min)(skip + (k - 1) * n + 1, rgr.size()));
+    skip = n - 1;
+  }
+
+  constexpr std::size_t strided(std::size_t s) const {
+    return s > skip ? (s - skip - 1) / n + 1 : 0;
+  }
+
+  std::size_t n;
+  Ranger rgr;
+  std::size_t skip = 0;
+};
+
+/**
+ * @brief stride
+ *
+ * Returns a ranger over every `n`-th element of `rgr`, starting with the
+ * first one (`n == 0` is taken as `1`).
+ *
+ * @tparam Ranger
+ * @param n
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> constexpr auto stride(std::size_t n, Ranger rgr) {
+  return detail::stage(
+      "stride", stride_ranger<Ranger>{n != 0 ? n : 1, std::move(rgr)}, rgr);
+}
+
+/**
+ * @brief window_view
+ *
+ * The last `size()` elements handed by `sliding_window`, oldest first. It
+ * refers to storage in the ranger and is valid until the ranger is resumed.
+ *
+ * @tparam T
+ */
+template <typename T> class window_view {
+public:
+  constexpr window_view() = default;
+  constexpr window_view(const T *ring, std::size_t n, std::size_t first)
+      : ring{ring}, n{n}, first{first} {}
+
+  constexpr std::size_t size() const { return n; }
+  constexpr const T &operator[](std::size_t i) const {
+    const auto j = first + i;
+    return ring[j < n ? j : j - n];
+  }
+  constexpr const T &front() const { return ring[first]; }
+  constexpr const T &back() const { return (*this)[n - 1]; }
+
+private:
+  const T *ring = nullptr;
+  std::size_t n = 0, first = 0;
+};
+
+namespace detail {
+
+/* Circular buffer with the last n values pushed; once full, pos is the
+ * oldest one, which the next push passes to evict before overwriting it.
+ */
+template <typename T> class window_ring {
+public:
+  explicit window_ring(std::size_t n) : n{n} { v.reserve(n); }
+
+  template <typename U, typename Evict>
+  TRANSRANGERS_HOT const T &push(U &&x, Evict evict) {
+    if (v.size() < n) {
+      v.push_back(std::forward<U>(x));
+      return v.back();
+    }
+    auto &slot = v[pos];
+    evict(static_cast<const T &>(slot));
+    slot = std::forward<U>(x);
+    pos = pos + 1 != n ? pos + 1 : 0;
+    return slot;
+  }
+
+  bool full() const { return v.size() == n; }
+  window_view<T> view() const { return {v.data(), n, pos}; }
+
+private:
+  std::size_t n, pos = 0;
+  std::vector<T> v;
+};
+
+template <typename Hint>
+constexpr auto window_hint(Hint hint, std::size_t n) {
+  if constexpr (std::is_same<Hint, no_size_hint>::value) {
+    (void)n;
+    return hint;
+  } else
+    return hint >= n ? hint - n + 1 : std::size_t(0);
+}
+
+/* Minimum (Compare = std::less<T>) or maximum of a sliding window of n, as
+ * in van Herk/Gil-Werman: the input is split into blocks of n and, each time
+ * a block is complete, its suffix extrema are computed; a window is then a
+ * suffix of the previous block plus a prefix of the current one, so every
+ * element costs about three comparisons, with no data-dependent branches.
+ * (A monotonic queue is amortized O(1) too but mispredicts on unsorted
+ * data.)
+ */
+template <typename T, typename Compare> class extremum_window {
+public:
+  explicit extremum_window(std::size_t n) : cur(n), suf(n) {}
+
+  void push(const T &x) {
+    const auto n = cur.size();
+    cur[i] = x;
+    pre = i == 0 || cmp(x, pre) ? x : pre;
+    if (++i == n) {
+      i = 0;
+      suf[n - 1] = cur[n - 1];
+      for (auto k = n - 1; k-- != 0;)
+        suf[k] = cmp(cur[k], suf[k + 1]) ? cur[k] : suf[k + 1];
+      val = suf[0];
+    } else
+      val = cmp(suf[i], pre) ? suf[i] : pre;
+  }
+  void pop(const T &) {}
+  const T &value() const { return val; }
+
+private:
+  std::vector<T> cur, suf;
+  std::size_t i = 0;
+  T pre{}, val{};
+  Compare cmp;
+};
+
+struct reverse_less {
+  template <typename T> bool operator()(const T &x, const T &y) const {
+    return y < x;
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief window_sum
+ *
+ * `sliding_window` aggregate: sum of the window, updated by adding the
+ * incoming element and subtracting the outgoing one (floating-point sums
+ * accumulate rounding errors accordingly).
+ */
+struct window_sum {
+  template <typename T> struct state {
+    explicit state(std::size_t) {}
+
+    void push(const T &x) { total = total + x; }
+    void pop(const T &x) { total = total - x; }
+    const T &value() const { return total; }
+
+    T total{};
+  };
+};
+
+/**
+ * @brief window_min
+ *
+ * `sliding_window` aggregate: minimum of the window as per `<`, in O(1)
+ * per element.
+ */
+struct window_min {
+  template <typename T>
+  using state = detail::extremum_window<T, std::less<T>>;
+};
+
+/**
+ * @brief window_max
+ *
+ * `sliding_window` aggregate: maximum of the window as per `<`, in O(1)
+ * per element.
+ */
+struct window_max {
+  template <typename T>
+  using state = detail::extremum_window<T, detail::reverse_less>;
+};
+
+/**
+ * @brief sliding_window
+ *
+ * Returns a ranger over the windows of `n` consecutive elements of `rgr`
+ * (`n == 0` is taken as `1`), whose cursors are pointers to a `window_view`
+ * kept in the ranger. Elements are copied into a ring of `n` slots allocated
+ * once, so any input ranger will do.
+ *
+ * @tparam Ranger
+ * @param n
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> auto sliding_window(std::size_t n, Ranger rgr) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
+  using view = window_view<value_type>;
+
+  n = n != 0 ? n : 1;
+  auto hint = detail::window_hint(detail::hint_of(rgr), n);
+  auto res = detail::ranger_hinted_by<const view *>(
+      hint, [rgr = std::move(rgr), ring = detail::window_ring<value_type>{n},
+             out = view{}](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              ring.push(*p, [](const value_type &) {});
+              if (!ring.full())
+                return true;
+              out = ring.view();
+              return dst(static_cast<const view *>(&out));
+            }));
+      });
+  return detail::stage("sliding_window", std::move(res), rgr);
+}
+
+/**
+ * @brief sliding_window (aggregate)
+ *
+ * Returns a ranger over an aggregate of each window of `n` consecutive
+ * elements of `rgr`, maintained in O(1) (amortized) per element: `Agg` is
+ * `window_sum`, `window_min`, `window_max` or any type with a nested
+ * `state<T>` constructible from `n` and with `push(x)` (incoming element),
+ * `pop(x)` (outgoing element) and `value()`. Cursors are pointers to the
+ * value kept in the ranger and remain valid until it is resumed.
+ *
+ * @tparam Agg
+ * @tparam Ranger
+ * @param n
+ * @param agg
+ * @param rgr
+ * @return auto
+ */
+template <typename Agg, typename Ranger>
+auto sliding_window(std::size_t n, Agg, Ranger rgr) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
+  using state = typename Agg::template state<value_type>;
+  using result_type =
+      std::decay_t<decltype(std::declval<const state &>().value())>;
+
+  n = n != 0 ? n : 1;
+  auto hint = detail::window_hint(detail::hint_of(rgr), n);
+  auto res = detail::ranger_hinted_by<const result_type *>(
+      hint, [rgr = std::move(rgr), ring = detail::window_ring<value_type>{n},
+             st = state{n}, out = result_type{}](
+                auto dst) TRANSRANGERS_HOT_MUTABLE {
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              st.push(ring.push(*p, [&](const value_type &x)
+                                        TRANSRANGERS_HOT { st.pop(x); }));
+              if (!ring.full())
+                return true;
+              out = st.value();
+              return dst(static_cast<const result_type *>(&out));
+            }));
+      });
+  return detail::stage("sliding_window", std::move(res), rgr);
+}
+
+/**
+ * @brief partial sum (cummutative sum)
+ *
+ * The `partial_sum` function is a part of the Transrangers library. It takes a
+ * range `rgr` and an initial value `init` as input and returns the cumulative
+ * sum of the elements in the range.
+ *
+ * @tparam Ranger
+ * @tparam T
+ * @param rgr
+ * @param init
+ * @return T
+ */
+template <typename Ranger, typename T> T partial_sum(Ranger rgr, T init) {
+  rgr(make_exhaustive_consumer([&init](const auto &p) TRANSRANGERS_HOT {
+    init = std::move(init) + *p;
+    *p = init;
+    return true;
+  }));
+  return init;
+}
+
+// inclusive_scan, exclusive_scan
+
+/**
+ * @brief inclusive_scan
+ *
+ * Ranger over the running folds `init op x0`, `(init op x0) op x1`, ... of
+ * the elements of `rgr`, or `x0`, `x0 op x1`, ... if no `init` is given.
+ * Cursors are pointers to the running value kept in the ranger and remain
+ * valid until it is resumed. For large random-access inputs see
+ * `par_inclusive_scan` in transrangers_par.hpp.
+ *
+ * @tparam Op
+ * @tparam T
+ * @tparam Ranger
+ * @param op
+ * @param init
+ * @param rgr
+ * @return auto
+ */
+template <typename Op, typename T, typename Ranger>
+auto inclusive_scan(Op op, T init, Ranger rgr) {
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<const T *>(
+      hint, [op = std::move(op), acc = std::move(init),
+             rgr = std::move(rgr)](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              acc = op(std::move(acc), *p);
+              return dst(static_cast<const T *>(&acc));
+            }));
+      });
+  return detail::stage("inclusive_scan", std::move(res), rgr);
+}
+
+template <typename Op, typename Ranger> auto inclusive_scan(Op op, Ranger rgr) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
+
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<const value_type *>(
+      hint, [op = std::move(op), acc = std::optional<value_type>{},
+             rgr = std::move(rgr)](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              if (acc)
+                *acc = op(std::move(*acc), *p);
+              else
+                acc.emplace(*p);
+              return dst(static_cast<const value_type *>(&*acc));
+            }));
+      });
+  return detail::stage("inclusive_scan", std::move(res), rgr);
+}
+
+/**
+ * @brief exclusive_scan
+ *
+ * Ranger over `init`, `init op x0`, `(init op x0) op x1`, ... with one value
+ * per element of `rgr` (the last element is not folded in).
+ *
+ * @tparam Op
+ * @tparam T
+ * @tparam Ranger
+ * @param op
+ * @param init
+ * @param rgr
+ * @return auto
+ */
+template <typename Op, typename T, typename Ranger>
+auto exclusive_scan(Op op, T init, Ranger rgr) {
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<const T *>(
+      hint, [op = std::move(op), acc = init, out = init,
+             rgr = std::move(rgr)](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              out = acc;
+              acc = op(std::move(acc), *p);
+              return dst(static_cast<const T *>(&out));
+            }));
+      });
+  return detail::stage("exclusive_scan", std::move(res), rgr);
+}
+
+// group_reduce, run_length, chunk_by
+
+/**
+ * @brief group_reduce
+ *
+ * Ranger over the maximal runs of consecutive elements with equal `key`,
+ * each reduced in the same pass to a `std::pair` of the key and
+ * `op(...op(op(init, x0), x1)..., xn)`. The aggregate being built is kept
+ * in the ranger, so resuming (e.g. inside `join`) continues the current run.
+ * Cursors are pointers into the ranger and remain valid until it is resumed.
+ *
+ * @tparam Key
+ * @tparam Op
+ * @tparam T
+ * @tparam Ranger
+ * @param key
+ * @param op
+ * @param init
+ * @param rgr
+ * @return auto
+ */
+template <typename Key, typename Op, typename T, typename Ranger>
+auto group_reduce(Key key, Op op, T init, Ranger rgr) {
+  using cursor = typename Ranger::cursor;
+  using key_type =
+      std::decay_t<decltype(key(*std::declval<const cursor &>()))>;
+  using group = std::pair<key_type, T>;
+
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<const group *>(
+      hint, [key = std::move(key), op = std::move(op), init = std::move(init),
+             rgr = std::move(rgr), grp = std::optional<group>{},
+             out = std::optional<group>{},
+             done = false](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        if (!done) {
+          if (!rgr(detail::exhaustive_like<decltype(dst)>(
+                  [&](const auto &p) TRANSRANGERS_HOT {
+                    auto k = key(*p);
+                    if (grp && grp->first == k) {
+                      grp->second = op(std::move(grp->second), *p);
+                      return true;
+                    }
+                    auto emit = grp.has_value();
+                    if (emit)
+                      out.emplace(std::move(*grp));
+                    grp.emplace(std::move(k), op(init, *p));
+                    return !emit || dst(static_cast<const group *>(&*out));
+                  })))
+            return false;
+          done = true;
+        }
+        if (!grp)
+          return true;
+        out.emplace(std::move(*grp));
+        grp.reset();
+        return dst(static_cast<const group *>(&*out));
+      });
+  return detail::stage("group_reduce", std::move(res), rgr);
+}
+
+/**
+ * @brief run_length
+ *
+ * Ranger over the runs of consecutive equal elements as `std::pair`s of the
+ * value and the length of the run.
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> auto run_length(Ranger rgr) {
+  return group_reduce([](const auto &x) { return x; },
+                      [](std::size_t n, const auto &) { return n + 1; },
+                      std::size_t(0), std::move(rgr));
+}
+
+/**
+ * @brief chunk_by
+ *
+ * Ranger over the maximal chunks of consecutive elements `x`, `y` for which
+ * `pred(x, y)` holds, each one an `all_ranger` over the chunk (so that e.g.
+ * `join(chunk_by(pred, rgr))` yields the elements of `rgr` back). The chunks
+ * refer to the source elements, so `rgr` must have forward iterators as
+ * cursors; use `group_reduce` to aggregate chunks of other rangers.
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred_
+ * @param rgr
+ * @return auto
+ */
+template <typename Pred, typename Ranger> auto chunk_by(Pred pred_, Ranger rgr) {
+  using cursor = typename Ranger::cursor;
+  static_assert(detail::is_iterator<cursor>::value &&
+                    std::is_base_of<std::forward_iterator_tag,
+                                    typename std::iterator_traits<
+                                        cursor>::iterator_category>::value,
+                "chunk_by requires forward iterator cursors");
+  using chunk = all_ranger<cursor>;
+
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<const chunk *>(
+      hint, [rgr = std::move(rgr), pred = pred_box(std::move(pred_)),
+             first = cursor{}, prev = cursor{}, started = false, done = false,
+             out = chunk{}](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        if (!done) {
+          if (!rgr(detail::exhaustive_like<decltype(dst)>(
+                  [&](const auto &p) TRANSRANGERS_HOT {
+                    if (!started) {
+                      started = true;
+                      first = prev = p;
+                      return true;
+                    }
+                    if (pred(*prev, *p)) {
+                      prev = p;
+                      return true;
+                    }
+                    out = chunk{first, std::next(prev)};
+                    first = prev = p;
+                    return dst(static_cast<const chunk *>(&out));
+                  })))
+            return false;
+          done = true;
+        }
+        if (!started)
+          return true;
+        started = false;
+        out = chunk{first, std::next(prev)};
+        return dst(static_cast<const chunk *>(&out));
+      });
+  return detail::stage("chunk_by", std::move(res), rgr);
+}
+
+// to_vector, collect_into
+
+namespace detail {
+
+template <typename Container, typename = void>
+struct has_reserve : std::false_type {};
+
+template <typename Container>
+struct has_reserve<Container,
+                   std::void_t<decltype(std::declval<Container &>().reserve(
+                       std::size_t{}))>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * @brief collect_into (container)
+ *
+ * Appends the elements of `rgr` to `c`. If `rgr` is sized, exactly the
+ * needed capacity is reserved beforehand; if it only has a size hint (e.g.
+ * `filter` or `unique` over a sized ranger), the hint is reserved as an upper
+ * bound. Otherwise the container grows on its own.
+ *
+ * @tparam Container
+ * @tparam Ranger
+ * @param c
+ * @param rgr
+ * @return Container&
+ */
+template <typename Container, typename Ranger>
+std::enable_if_t<std::is_class<Container>::value &&
+                     !detail::is_iterator<Container>::value,
+                 Container &>
+collect_into(Container &c, Ranger rgr) {
+  if constexpr (has_size_hint<Ranger>::value &&
+                detail::has_reserve<Container>::value)
+    c.reserve(c.size() + detail::size_hint(rgr));
+  rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+    c.insert(c.end(), *p);
+    return true;
+  }));
+  return c;
+}
+
+/**
+ * @brief collect_into (output iterator)
+ *
+ * Writes the elements of `rgr` to `out` and returns the iterator past the
+ * last element written.
+ *
+ * @tparam OutputIterator
+ * @tparam Ranger
+ * @param out
+ * @param rgr
+ * @return OutputIterator
+ */
+template <typename OutputIterator, typename Ranger>
+constexpr std::enable_if_t<detail::is_iterator<OutputIterator>::value,
+                           OutputIterator>
+collect_into(OutputIterator out, Ranger rgr) {
+  rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+    *out = *p;
+    ++out;
+    return true;
+  }));
+  return out;
+}
+
+/**
+ * @brief to_vector
+ *
+ * Returns a `std::vector` with the elements of `rgr` (see `collect_into`).
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @return std::vector<value type of Ranger::cursor>
+ */
+template <typename Ranger> auto to_vector(Ranger rgr) {
+  std::vector<detail::cursor_value_t<typename Ranger::cursor>> v;
+  collect_into(v, std::move(rgr));
+  return v;
+}
+
+/**
+ * @brief to_array
+ *
+ * Returns a `std::array` with the first `N` elements of `rgr`, the rest of
+ * the array being value-initialized if `rgr` has fewer. Usable in constant
+ * expressions, e.g. to build lookup tables at compile time:
+ * `constexpr auto lut = to_array<256>(transform(f, all(py::range(256))));`
+ *
+ * @tparam N
+ * @tparam Ranger
+ * @param rgr
+ * @return std::array<value type of Ranger::cursor, N>
+ */
+template <std::size_t N, typename Ranger> constexpr auto to_array(Ranger rgr) {
+  std::array<detail::cursor_value_t<typename Ranger::cursor>, N> a{};
+  if constexpr (N > 0) {
+    std::size_t n = 0;
+    rgr([&](const auto &p) TRANSRANGERS_HOT {
+      a[n++] = *p;
+      return n != N;
+    });
+  }
+  return a;
+}
+
+#if __has_include(<memory_resource>)
+/**
+ * @brief to_vector (memory resource)
+ *
+ * Returns a `std::pmr::vector` allocated from `mr` with the elements of
+ * `rgr`. With a `std::pmr::monotonic_buffer_resource`, the reservation done
+ * for sized and hinted rangers means a single allocation from the arena.
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @param mr
+ * @return std::pmr::vector<value type of Ranger::cursor>
+ */
+template <typename Ranger>
+auto to_vector(Ranger rgr, std::pmr::memory_resource *mr) {
+  std::pmr::vector<detail::cursor_value_t<typename Ranger::cursor>> v{mr};
+  collect_into(v, std::move(rgr));
+  return v;
+}
+#endif
+
+// select, gather
+
+/**
+ * @brief selection
+ *
+ * Positions, in traversal order and starting at 0, of the elements that
+ * satisfy a predicate, as returned by `select`. It can drive `gather` over
+ * any number of random-access rangers of the same length.
+ */
+using selection = std::vector<std::size_t>;
+
+/**
+ * @brief select
+ *
+ * Evaluates `pred` over `rgr` and returns the positions of the elements
+ * satisfying it. Unlike `filter`, no branch depends on the outcome of
+ * `pred`: every position is written to the selection vector and the write
+ * cursor advances by the predicate's result, so the pass runs at the same
+ * speed regardless of selectivity. When `TRANSRANGERS_BATCH_WIDTH` is
+ * greater than one, elements are requested in batches (see
+ * `batch_consumer`).
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred_
+ * @param rgr
+ * @return selection
+ */
+template <typename Pred, typename Ranger>
+selection select(Pred pred_, Ranger rgr) {
+  constexpr auto W = detail::batch_width;
+
+  auto pred = pred_box(std::move(pred_));
+  selection sel;
+  if constexpr (has_size_hint<Ranger>::value)
+    sel.resize(detail::size_hint(rgr) + W);
+  std::size_t i = 0, n = 0;
+  auto room = [&] {
+    if (sel.size() - n < W)
+      sel.resize(2 * sel.size() + W);
+    return sel.data() + n;
+  };
+  rgr(make_exhaustive_consumer(make_batch_consumer<W>([&](const auto &p)
+                                                          TRANSRANGERS_HOT {
+    using arg_type = std::decay_t<decltype(p)>;
+    auto out = room();
+    if constexpr (is_batch<arg_type>::value) {
+      static_assert(arg_type::width <= W);
+      std::size_t m = 0;
+      for (std::size_t l = 0; l < arg_type::width; ++l) {
+        const bool a = p.active(l);
+        out[m] = i;
+        m += a && pred(p[l]);
+        i += a;
+      }
+      n += m;
+    } else {
+      *out = i++;
+      n += pred(*p) != 0;
+    }
+    return true;
+  })));
+  sel.resize(n);
+  return sel;
+}
+
+/**
+ * @brief gather_batch
+ *
+ * `W` consecutive positions of a selection, looked up in a random-access
+ * ranger on access.
+ *
+ * @tparam Ranger
+ * @tparam Index
+ * @tparam W
+ */
+template <typename Ranger, typename Index, std::size_t W> struct gather_batch {
+  static constexpr std::size_t width = W;
+
+  static constexpr bool active(std::size_t) { return true; }
+  constexpr decltype(auto) operator[](std::size_t i) const {
+    return *rgr->at(static_cast<std::size_t>(idx[i]));
+  }
+
+  Ranger *rgr;
+  Index idx;
+};
+
+template <typename Ranger, typename Index, std::size_t W>
+struct is_batch<gather_batch<Ranger, Index, W>> : std::true_type {};
+
+/**
+ * @brief gather_ranger
+ *
+ * Ranger returned by `gather`. Sized and random access.
+ *
+ * @tparam Index
+ * @tparam Ranger
+ */
+template <typename Index, typename Ranger> struct gather_ranger {
+  using cursor = typename Ranger::cursor;
+
+  template <typename Dst>
+  TRANSRANGERS_HOT constexpr bool operator()(Dst dst) {
+    if constexpr (is_batch_consumer<Dst>::value) {
+      constexpr auto W = Dst::batch_width;
+      while (size() >= W) {
+        auto b = gather_batch<Ranger, Index, W>{&rgr, first};
+        first += W;
+        if (!dst(b))
+          return false;
+      }
+    }
+    return detail::run_random_access(*this, size(), dst);
+  }
+
+  constexpr std::size_t size() const {
+    return static_cast<std::size_t>(last - first);
+  }
+
+  constexpr cursor at(std::size_t i) {
+    return rgr.at(
+        static_cast<std::size_t>(first[static_cast<std::ptrdiff_t>(i)]));
+  }
+
+  constexpr void advance(std::size_t n) {
+    first += static_cast<std::ptrdiff_t>(n);
+  }
+
+  Index first, last;
+  Ranger rgr;
+};
+
+/**
+ * @brief gather
+ *
+ * Returns a ranger over the elements of the random-access ranger `rgr` at
+ * the positions of `sel` (typically the result of `select` over a ranger of
+ * the same length), so that one predicate pass can drive several columns:
+ * `auto s = select(pred, all(a)); zip(gather(s, all(b)), gather(s, all(c)))`.
+ * `sel` is held by reference. Fed to a batch consumer, the ranger hands out
+ * batches of gathered lanes.
+ *
+ * @tparam Indices
+ * @tparam Ranger
+ * @param sel
+ * @param rgr
+ * @return gather_ranger
+ */
+template <typename Indices, typename Ranger,
+          typename = std::enable_if_t<std::is_lvalue_reference<Indices>::value>>
+constexpr auto gather(Indices &&sel, Ranger rgr) {
+  static_assert(detail::random_access_ranger_v<Ranger>,
+                "gather requires a random-access ranger");
+  using std::begin;
+  using std::end;
+  using index = decltype(begin(sel));
+  static_assert(detail::is_random_access<index>::value,
+                "gather requires a random-access range of positions");
+
+  return detail::stage(
+      "gather",
+      gather_ranger<index, Ranger>{begin(sel), end(sel), std::move(rgr)}, rgr);
+}
+
+template <typename Indices, typename Ranger,
+          typename = std::enable_if_t<!std::is_lvalue_reference<Indices>::value>,
+          typename = void>
+auto gather(Indices &&sel, Ranger rgr) = delete;
+
+// merge, merge_all, set_union, set_intersection, set_difference
+
+namespace detail {
+
+/* Pulls the next cursor of rgr into head, false if rgr is exhausted. The
+ * cursor is looked at rather than rgr's return value, since a ranger may
+ * report that it is done along with its last element (e.g. take).
+ */
+template <typename Ranger, typename Cursor>
+TRANSRANGERS_HOT constexpr bool pull_into(Ranger &rgr, Cursor &head) {
+  bool pulled = false;
+  rgr([&](const auto &p) TRANSRANGERS_HOT {
+    head = p;
+    pulled = true;
+    return false;
+  });
+  return pulled;
+}
+
+/* Input i of a merge: an element of a tuple of rangers or of a container
+ * of rangers.
+ */
+template <typename Sources> struct merge_sources {
+  using container = std::remove_reference_t<Sources>;
+  using ranger_type = std::remove_reference_t<
+      decltype(*std::declval<range_iterator_t<container>>())>;
+
+  static std::size_t size(container &s) {
+    using std::begin;
+    using std::end;
+    return static_cast<std::size_t>(end(s) - begin(s));
+  }
+  template <typename Cursor>
+  static bool pull(container &s, std::size_t i, Cursor &head) {
+    using std::begin;
+    return pull_into(begin(s)[static_cast<std::ptrdiff_t>(i)], head);
+  }
+};
+
+template <typename... Rangers> struct merge_sources<std::tuple<Rangers...>> {
+  using ranger_type = std::tuple_element_t<0, std::tuple<Rangers...>>;
+
+  static constexpr std::size_t size(std::tuple<Rangers...> &) {
+    return sizeof...(Rangers);
+  }
+  template <typename Cursor>
+  static bool pull(std::tuple<Rangers...> &s, std::size_t i, Cursor &head) {
+    return pull(s, i, head, std::index_sequence_for<Rangers...>{});
+  }
+  template <typename Cursor, std::size_t... I>
+  static bool pull(std::tuple<Rangers...> &s, std::size_t i, Cursor &head,
+                   std::index_sequence<I...>) {
+    bool res = false;
+    (void)((i == I && (res = pull_into(std::get<I>(s), head), true)) || ...);
+    return res;
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief merge_ranger
+ *
+ * Ranger returned by `merge` and `merge_all`. The current cursor of every
+ * input is kept in the ranger (inputs are pulled one element at a time, as
+ * in `zip`, and each is resumed independently), and the inputs are ranked
+ * by a loser tree: after emitting the smallest element, only the path from
+ * its input to the root is replayed, with one comparison per level, i.e.
+ * about `log2(k)` comparisons per element for `k` inputs. Stable: equal
+ * elements come out in input order. Cursors of the inputs must stay valid
+ * after they have moved past them.
+ *
+ * @tparam Compare
+ * @tparam Sources `std::tuple` of rangers, or a container of rangers
+ */
+template <typename Compare, typename Sources> struct merge_ranger {
+  using sources = detail::merge_sources<Sources>;
+  using cursor = typename sources::ranger_type::cursor;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    if (tree.empty()) {
+      if (!build())
+        return true;
+    } else if (pending) {
+      pending = false;
+      refill(tree[0]);
+    }
+    for (;;) {
+      const auto w = tree[0];
+      if (!live[w])
+        return true;
+      if (!dst(static_cast<const cursor &>(heads[w]))) {
+        pending = true;
+        return false;
+      }
+      refill(w);
+    }
+  }
+
+  /* true if input a goes before input b */
+  bool beats(std::size_t a, std::size_t b) const {
+    if (live[a] & live[b]) { /* exhausted inputs lose */
+      /* a < b ? !cmp(*hb, *ha) : cmp(*ha, *hb), without branching */
+      const bool first = a < b;
+      const auto &x = heads[first ? b : a], &y = heads[first ? a : b];
+      return cmp(*x, *y) != first;
+    }
+    return live[a] != 0;
+  }
+
+  /* leaves are nodes k...2k-1, internal node n keeps the loser of the
+   * match between the winners of 2n and 2n + 1
+   */
+  std::size_t play(std::size_t n) {
+    const auto k = heads.size();
+    if (n >= k)
+      return n - k;
+    auto w1 = play(2 * n), w2 = play(2 * n + 1);
+    if (beats(w2, w1))
+      std::swap(w1, w2);
+    tree[n] = w2;
+    return w1;
+  }
+
+  bool build() {
+    const auto k = sources::size(rgrs);
+    if (k == 0)
+      return false;
+    heads.resize(k);
+    live.resize(k);
+    tree.resize(k);
+    for (std::size_t i = 0; i < k; ++i)
+      live[i] = sources::pull(rgrs, i, heads[i]);
+    tree[0] = play(1);
+    return true;
+  }
+
+  TRANSRANGERS_HOT void refill(std::size_t w) {
+    const auto k = heads.size();
+    live[w] = sources::pull(rgrs, w, heads[w]);
+    for (auto n = (w + k) / 2; n != 0; n /= 2) {
+      const auto t = tree[n];
+      const bool b = beats(t, w);
+      tree[n] = b ? w : t;
+      w = b ? t : w;
+    }
+    tree[0] = w;
+  }
+
+  Compare cmp;
+  Sources rgrs;
+  std::vector<cursor> heads = {};
+  std::vector<char> live = {};
+  std::vector<std::size_t> tree = {};
+  bool pending = false;
+};
+
+/**
+ * @brief merge
+ *
+ * Returns a ranger over the elements of the rangers `rgr`, `rgrs...`, each
+ * sorted by `cmp`, in `cmp` order (see `merge_ranger`). All inputs must have
+ * the same cursor type.
+ *
+ * @tparam Compare
+ * @tparam Ranger
+ * @tparam Rangers
+ * @param cmp
+ * @param rgr
+ * @param rgrs
+ * @return auto
+ */
+template <typename Compare, typename Ranger, typename... Rangers>
+auto merge(Compare cmp, Ranger rgr, Rangers... rgrs) {
+  static_assert(
+      (std::is_same<typename Ranger::cursor, typename Rangers::cursor>::value &&
+       ...),
+      "merge requires inputs with the same cursor type");
+  using sources = std::tuple<Ranger, Rangers...>;
+
+  return detail::stage("merge",
+                       merge_ranger<Compare, sources>{
+                           std::move(cmp),
+                           sources{std::move(rgr), std::move(rgrs)...}},
+                       rgr, rgrs...);
+}
+
+/**
+ * @brief merge_all
+ *
+ * `merge` over a number of inputs known at run time: `rgrs` is a container
+ * of rangers (say, one per shard), referred to if an lvalue and owned
+ * otherwise.
+ *
+ * @tparam Compare
+ * @tparam Rangers
+ * @param cmp
+ * @param rgrs
+ * @return auto
+ */
+template <typename Compare, typename Rangers>
+auto merge_all(Compare cmp, Rangers &&rgrs) {
+  return detail::stage("merge_all",
+                       merge_ranger<Compare, Rangers>{
+                           std::move(cmp), std::forward<Rangers>(rgrs)});
+}
+
+namespace detail {
+
+/* Input of the set operations, read one element ahead. */
+template <typename Ranger, typename = void> struct set_input {
+  using cursor = typename Ranger::cursor;
+
+  bool peek() {
+    if (!has && !done) {
+      done = !pull_into(rgr, head);
+      has = !done;
+    }
+    return has;
+  }
+  const cursor &front() const { return head; }
+  void pop() { has = false; }
+
+  /* drops the elements less than x, false if none is left */
+  template <typename T, typename Compare>
+  bool skip_less(const T &x, Compare &cmp) {
+    while (peek() && cmp(*head, x))
+      pop();
+    return has;
+  }
+
+  Ranger rgr;
+  cursor head = {};
+  bool has = false, done = false;
+};
+
+/* Random-access input: skip_less gallops (exponential, then binary search
+ * with at()) and jumps with advance().
+ */
+template <typename Ranger>
+struct set_input<Ranger, std::enable_if_t<random_access_ranger_v<Ranger>>> {
+  using cursor = typename Ranger::cursor;
+
+  bool peek() { return rgr.size() != 0; }
+  cursor front() { return rgr.at(0); }
+  void pop() { rgr.advance(1); }
+
+  template <typename T, typename Compare>
+  bool skip_less(const T &x, Compare &cmp) {
+    const auto n = rgr.size();
+    if (n == 0 || !cmp(*rgr.at(0), x))
+      return n != 0;
+    std::size_t lo = 0, hi = 1; /* *at(lo) < x */
+    while (hi < n && cmp(*rgr.at(hi), x)) {
+      lo = hi;
+      hi = 2 * hi + 1;
+    }
+    if (hi > n)
+      hi = n;
+    while (hi - lo > 1) { /* *at(lo) < x <= *at(hi), at(n) being "infinite" */
+      const auto mid = lo + (hi - lo) / 2;
+      if (cmp(*rgr.at(mid), x))
+        lo = mid;
+      else
+        hi = mid;
+    }
+    rgr.advance(hi);
+    return hi != n;
+  }
+
+  Ranger rgr;
+};
+
+enum class set_op { union_, intersection, difference };
+
+} // namespace detail
+
+/**
+ * @brief set_ranger
+ *
+ * Ranger returned by `set_union`, `set_intersection` and `set_difference`,
+ * with the multiset semantics of their `std::` namesakes. Each input is read
+ * one element ahead and resumed independently. Random-access inputs skip
+ * runs of elements that cannot be in the result by galloping, so that
+ * intersecting a short list with a long one costs
+ * O(short * log(long / short)) comparisons.
+ *
+ * @tparam Op
+ * @tparam Compare
+ * @tparam Ranger1
+ * @tparam Ranger2
+ */
+template <detail::set_op Op, typename Compare, typename Ranger1,
+          typename Ranger2>
+struct set_ranger {
+  using cursor = typename Ranger1::cursor;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    for (;;) {
+      if constexpr (Op == detail::set_op::union_) {
+        const bool ha = a.peek(), hb = b.peek();
+        if (!ha && !hb)
+          return true;
+        if (!hb || (ha && !cmp(*b.front(), *a.front()))) {
+          const cursor p = a.front();
+          if (hb && !cmp(*p, *b.front()))
+            b.pop();
+          a.pop();
+          if (!dst(p))
+            return false;
+        } else {
+          const cursor p = b.front();
+          b.pop();
+          if (!dst(p))
+            return false;
+        }
+      } else {
+        if (!a.peek())
+          return true;
+        const cursor p = a.front();
+        const bool found = b.skip_less(*p, cmp) && !cmp(*p, *b.front());
+        if constexpr (Op == detail::set_op::intersection) {
+          if (!b.peek())
+            return true;
+          if (!found) { /* *p < *b.front() */
+            const auto q = b.front();
+            a.skip_less(*q, cmp);
+            continue;
+          }
+          a.pop();
+          b.pop();
+          if (!dst(p))
+            return false;
+        } else {
+          a.pop();
+          if (found)
+            b.pop();
+          else if (!dst(p))
+            return false;
+        }
+      }
+    }
+  }
+
+  Compare cmp;
+  detail::set_input<Ranger1> a;
+  detail::set_input<Ranger2> b;
+};
+
+/**
+ * @brief set_union
+ *
+ * Elements of the rangers `rgr1` and `rgr2`, sorted by `cmp`, that are in
+ * either, as with `std::set_union` (see `set_ranger`). Both must have the
+ * same cursor type.
+ *
+ * @return auto
+ */
+template <typename Compare, typename Ranger1, typename Ranger2>
+auto set_union(Compare cmp, Ranger1 rgr1, Ranger2 rgr2) {
+  static_assert(
+      std::is_same<typename Ranger1::cursor, typename Ranger2::cursor>::value,
+      "set_union requires inputs with the same cursor type");
+  return detail::stage(
+      "set_union",
+      set_ranger<detail::set_op::union_, Compare, Ranger1, Ranger2>{
+          std::move(cmp), {std::move(rgr1)}, {std::move(rgr2)}},
+      rgr1, rgr2);
+}
+
+/**
+ * @brief set_intersection
+ *
+ * Elements of `rgr1` sorted by `cmp` that are also in `rgr2`, as with
+ * `std::set_intersection` (see `set_ranger`).
+ *
+ * @return auto
+ */
+template <typename Compare, typename Ranger1, typename Ranger2>
+auto set_intersection(Compare cmp, Ranger1 rgr1, Ranger2 rgr2) {
+  return detail::stage(
+      "set_intersection",
+      set_ranger<detail::set_op::intersection, Compare, Ranger1, Ranger2>{
+          std::move(cmp), {std::move(rgr1)}, {std::move(rgr2)}},
+      rgr1, rgr2);
+}
+
+/**
+ * @brief set_difference
+ *
+ * Elements of `rgr1` sorted by `cmp` that are not in `rgr2`, as with
+ * `std::set_difference` (see `set_ranger`).
+ *
+ * @return auto
+ */
+template <typename Compare, typename Ranger1, typename Ranger2>
+auto set_difference(Compare cmp, Ranger1 rgr1, Ranger2 rgr2) {
+  return detail::stage(
+      "set_difference",
+      set_ranger<detail::set_op::difference, Compare, Ranger1, Ranger2>{
+          std::move(cmp), {std::move(rgr1)}, {std::move(rgr2)}},
+      rgr1, rgr2);
+}
+
+// top_k, nth, min_max, reservoir_sample, quantile
+
+namespace detail {
+
+/* Binary heap holding the (at most) k first elements in cmp order seen so
+ * far; top() is the last of them, the one evicted by the next better element.
+ */
+template <typename T, typename Compare> class bounded_heap {
+public:
+  bounded_heap(std::size_t k, Compare cmp) : k{k}, cmp{std::move(cmp)} {
+    v.reserve(k);
+  }
+
+  template <typename U> void push(U &&x) {
+    if (v.size() < k) {
+      v.push_back(std::forward<U>(x));
+      std::push_heap(v.begin(), v.end(), cmp);
+    } else if (k != 0 && cmp(x, v.front()))
+      replace_top(T(std::forward<U>(x)));
+  }
+
+  bool full() const { return v.size() == k; }
+  const T &top() const { return v.front(); }
+  std::vector<T> sorted() && {
+    std::sort_heap(v.begin(), v.end(), cmp);
+    return std::move(v);
+  }
+
+private:
+  /* pop_heap + push_heap in a single sift-down */
+  void replace_top(T x) {
+    const auto n = v.size();
+    std::size_t i = 0;
+    for (auto c = std::size_t(1); c < n; c = 2 * i + 1) {
+      if (c + 1 < n && cmp(v[c], v[c + 1]))
+        ++c;
+      if (!cmp(x, v[c]))
+        break;
+      v[i] = std::move(v[c]);
+      i = c;
+    }
+    v[i] = std::move(x);
+  }
+
+  std::size_t k;
+  Compare cmp;
+  std::vector<T> v;
+};
+
+template <typename Ranger, typename Compare>
+auto top_k_heap(std::size_t k, Compare cmp, Ranger rgr) {
+  using value_type = cursor_value_t<typename Ranger::cursor>;
+
+  bounded_heap<value_type, Compare> h{k, std::move(cmp)};
+  if (k != 0)
+    rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+      h.push(*p);
+      return true;
+    }));
+  return h;
+}
+
+/* splitmix64 */
+class sample_rng {
+public:
+  explicit sample_rng(std::uint64_t seed) : state{seed} {}
+
+  std::uint64_t operator()() {
+    auto z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+  double uniform() { /* in (0, 1) */
+    return (static_cast<double>((*this)() >> 11) + 0.5) * 0x1.0p-53;
+  }
+
+private:
+  std::uint64_t state;
+};
+
+/* Uniform sample of k elements (Li's algorithm L): after the first k
+ * elements, only the ones at precomputed random gaps are looked at.
+ */
+template <typename T> class reservoir {
+public:
+  reservoir(std::size_t k, std::uint64_t seed) : k{k}, rng{seed} {
+    v.reserve(k);
+  }
+
+  template <typename U> void push(U &&x) {
+    if (seen++ < k) {
+      v.push_back(std::forward<U>(x));
+      if (seen == k) {
+        w = std::exp(std::log(rng.uniform()) / static_cast<double>(k));
+        schedule();
+      }
+    } else if (seen == next) {
+      v[rng() % k] = std::forward<U>(x);
+      w *= std::exp(std::log(rng.uniform()) / static_cast<double>(k));
+      schedule();
+    }
+  }
+
+  std::uint64_t count() const { return seen; }
+  std::vector<T> &sample() { return v; }
+
+private:
+  void schedule() {
+    auto gap = std::floor(std::log(rng.uniform()) / std::log1p(-w));
+    next = gap < 9.0e18 ? seen + static_cast<std::uint64_t>(gap) + 1
+                        : static_cast<std::uint64_t>(-1);
+  }
+
+  std::size_t k;
+  sample_rng rng;
+  std::vector<T> v;
+  std::uint64_t seen = 0, next = 0;
+  double w = 0.0;
+};
+
+template <typename Ranger>
+auto reservoir_of(std::size_t k, Ranger rgr, std::uint64_t seed) {
+  reservoir<cursor_value_t<typename Ranger::cursor>> r{k, seed};
+  rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+    r.push(*p);
+    return true;
+  }));
+  return r;
+}
+
+/* rank, counted from 0, of the q-quantile of n elements */
+inline std::uint64_t quantile_rank(double q, std::uint64_t n) {
+  q = q < 0.0 ? 0.0 : q > 1.0 ? 1.0 : q;
+  return static_cast<std::uint64_t>(q * static_cast<double>(n - 1));
+}
 
-// skip_first, skip_first_copy (assume the next item is available)
+} // namespace detail
 
 /**
- * @brief skip_first (assume the next item is available)
+ * @brief top_k
  *
- * The `skip_first` function is a part of the Transrangers library, which
- * provides an efficient and composable design pattern for range processing.
+ * Returns the first `k` elements of `rgr` in the order given by `cmp`
+ * (`std::greater<>` for the `k` largest), sorted, as `std::partial_sort`
+ * would leave them. A bounded heap of `k` elements is kept while consuming
+ * `rgr`, so the only allocation is the `k` slots of the result.
  *
- * @tparam Range
- * @param rng
- * @return auto
+ * @tparam Ranger
+ * @tparam Compare
+ * @param k
+ * @param cmp
+ * @param rgr
+ * @return std::vector<value type of Ranger::cursor>
  */
-template <typename Range> auto skip_first(Range &&rng) {
-  using std::begin;
-  using std::end;
-  using cursor = decltype(begin(rng));
+template <typename Compare, typename Ranger>
+auto top_k(std::size_t k, Compare cmp, Ranger rgr) {
+  return detail::top_k_heap(k, std::move(cmp), std::move(rgr)).sorted();
+}
+
+/**
+ * @brief nth
+ *
+ * Returns the element that would be at position `n` if `rgr` were sorted by
+ * `cmp`, as `std::nth_element` would find it, keeping only `n + 1` elements.
+ *
+ * @tparam Ranger
+ * @tparam Compare
+ * @param n
+ * @param cmp
+ * @param rgr
+ * @return std::optional<value type of Ranger::cursor>, empty if `rgr` has no
+ * more than `n` elements
+ */
+template <typename Compare, typename Ranger>
+auto nth(std::size_t n, Compare cmp, Ranger rgr) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
 
-  // Sorry, I don't check if the second item is available.
-  return ranger<cursor>([first = ++begin(rng), last = end(rng)](auto dst)
-                            TRANSRANGERS_HOT_MUTABLE {
-                              auto it = first;
-                              while (it != last)
-                                if (!dst(it++)) {
-                                  first = it;
-                                  return false;
-                                }
-                              return true;
-                            });
+  auto h = detail::top_k_heap(n + 1, std::move(cmp), std::move(rgr));
+  return h.full() ? std::optional<value_type>{h.top()} : std::nullopt;
 }
 
 /**
- * @brief
+ * @brief min_max
  *
- * @tparam Range
+ * Returns the smallest and largest elements of `rgr` as per `<`. For
+ * arithmetic elements, both are updated with conditional moves, so that loops
+ * over contiguous data vectorize; when `TRANSRANGERS_BATCH_WIDTH` is
+ * greater than one, arithmetic elements are requested in batches and kept in
+ * one minimum and maximum per lane (see `batch_consumer`).
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @return std::optional<std::pair<T, T>>, empty if `rgr` is empty
  */
-template <typename Range> struct skip_first_copy {
-  using ranger = decltype(skip_first(std::declval<Range &>()));
-  using cursor = typename ranger::cursor;
+template <typename Ranger> auto min_max(Ranger rgr) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
+
+  std::optional<std::pair<value_type, value_type>> res;
+  if (rgr([&](const auto &p) TRANSRANGERS_HOT {
+        res.emplace(*p, *p);
+        return false;
+      }))
+    return res;
+  auto &mn = res->first;
+  auto &mx = res->second;
+  if constexpr (!std::is_arithmetic<value_type>::value) {
+    rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+      const value_type &x = *p;
+      if (x < mn)
+        mn = x;
+      else if (mx < x)
+        mx = x;
+      return true;
+    }));
+  } else if constexpr (detail::batch_width > 1) {
+    constexpr auto W = detail::batch_width;
+    const auto seed = mn;
+    value_type lmn[W], lmx[W];
+    for (std::size_t i = 0; i < W; ++i)
+      lmn[i] = lmx[i] = seed;
+    rgr(make_exhaustive_consumer(make_batch_consumer<W>([&](const auto &p)
+                                                            TRANSRANGERS_HOT {
+      using arg_type = std::decay_t<decltype(p)>;
+      if constexpr (is_batch<arg_type>::value) {
+        static_assert(arg_type::width <= W);
+        for (std::size_t i = 0; i < arg_type::width; ++i) {
+          const value_type x = p.active(i) ? value_type(p[i]) : seed;
+          lmn[i] = x < lmn[i] ? x : lmn[i];
+          lmx[i] = lmx[i] < x ? x : lmx[i];
+        }
+      } else {
+        const value_type &x = *p;
+        mn = x < mn ? x : mn;
+        mx = mx < x ? x : mx;
+      }
+      return true;
+    })));
+    for (std::size_t i = 0; i < W; ++i) {
+      mn = lmn[i] < mn ? lmn[i] : mn;
+      mx = mx < lmx[i] ? lmx[i] : mx;
+    }
+  } else {
+    rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+      const value_type x = *p;
+      mn = x < mn ? x : mn;
+      mx = mx < x ? x : mx;
+      return true;
+    }));
+  }
+  return res;
+}
 
-  template <typename F> auto operator()(const F &p) { return rgr(p); }
+/**
+ * @brief reservoir_sample
+ *
+ * Returns `k` elements of `rgr` picked uniformly at random (all of them, in
+ * input order, if `rgr` has no more than `k`), in a single pass and with
+ * memory for `k` elements.
+ *
+ * @tparam Ranger
+ * @param k
+ * @param rgr
+ * @param seed
+ * @return std::vector<value type of Ranger::cursor>
+ */
+template <typename Ranger>
+auto reservoir_sample(std::size_t k, Ranger rgr, std::uint64_t seed = 0) {
+  return std::move(detail::reservoir_of(k, std::move(rgr), seed).sample());
+}
 
-  Range rng;
-  ranger rgr = skip_first(rng);
-};
+/**
+ * @brief quantile
+ *
+ * Estimates the `q`-quantile (`0 <= q <= 1`, `0.5` for the median) of
+ * `rgr` as per `<`, taken as the element of rank `floor(q * (n - 1))`: the
+ * quantile is looked up with `std::nth_element` in a `reservoir_sample` of
+ * `sample_size` elements, and is therefore exact when `rgr` has no more
+ * than `sample_size` elements.
+ *
+ * @tparam Ranger
+ * @param q
+ * @param rgr
+ * @param sample_size
+ * @return std::optional<value type of Ranger::cursor>, empty if `rgr` is
+ * empty
+ */
+template <typename Ranger>
+auto quantile(double q, Ranger rgr, std::size_t sample_size = 4096) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
 
-template <typename Range>
-typename std::enable_if<std::is_rvalue_reference<Range &&>::value,
-                        skip_first_copy<Range>>::type
-skip_first(Range &&rng) {
-  return skip_first_copy<Range>{std::move(rng)};
+  auto s = reservoir_sample(sample_size, std::move(rgr));
+  if (s.empty())
+    return std::optional<value_type>{};
+  auto it = s.begin() + static_cast<std::ptrdiff_t>(
+                            detail::quantile_rank(q, s.size()));
+  std::nth_element(s.begin(), it, s.end());
+  return std::optional<value_type>{std::move(*it)};
 }
 
-// skip_last, skip_last_copy (assume the previous item is available)
-template <typename Range> auto skip_last(Range &&rng) {
-  using std::begin;
-  using std::end;
-  using cursor = decltype(begin(rng));
+// find_if, any_of, all_of, none_of, count_if, mismatch, equal
+
+namespace detail {
+
+/* Random-access rangers over arithmetic values are searched in blocks of
+ * search_block elements: the predicate is evaluated over a whole block with
+ * no early exit, so the compiler can turn the block into vector compares
+ * and a single test, and only the block holding the match is rescanned
+ * element by element.
+ */
+constexpr std::size_t search_block = 32;
+
+template <typename Ranger>
+constexpr bool block_searchable_v =
+    random_access_ranger_v<Ranger> &&
+    std::is_arithmetic<cursor_value_t<typename Ranger::cursor>>::value;
+
+} // namespace detail
+
+/**
+ * @brief find_if
+ *
+ * Returns the cursor to the first element of `rgr` satisfying `pred`, and
+ * leaves `rgr` right after it, so that resuming `rgr` (or calling `find_if`
+ * again) continues the search. If `rgr` is a temporary, the cursor is only
+ * usable when it does not refer to the ranger (as is the case with `all`).
+ * Random-access rangers over arithmetic values are scanned block-wise, which
+ * means `pred` may be invoked on a few elements past the match.
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred_
+ * @param rgr
+ * @return std::optional<Ranger::cursor>, empty if no element satisfies
+ * `pred`
+ */
+template <typename Pred, typename Ranger>
+auto find_if(Pred pred_, Ranger &&rgr) {
+  using ranger_type = std::remove_reference_t<Ranger>;
+  using cursor = typename ranger_type::cursor;
 
-  // Sorry, I don't check if the second last item is available.
-  return ranger<cursor>([first = begin(rng), last = --end(rng)](auto dst)
-                            TRANSRANGERS_HOT_MUTABLE {
-                              auto it = first;
-                              while (it != last)
-                                if (!dst(it++)) {
-                                  first = it;
-                                  return false;
-                                }
-                              return true;
-                            });
+  auto pred = pred_box(std::move(pred_));
+  std::optional<cursor> res;
+  if constexpr (detail::block_searchable_v<ranger_type>) {
+    constexpr auto B = detail::search_block;
+    const auto n = rgr.size();
+    std::size_t i = 0;
+    for (; n - i >= B; i += B) {
+      unsigned hit = 0;
+      for (std::size_t l = 0; l < B; ++l)
+        hit |= static_cast<unsigned>(pred(*rgr.at(i + l)) != 0);
+      if (hit)
+        break;
+    }
+    for (; i < n; ++i)
+      if (pred(*rgr.at(i))) {
+        res.emplace(rgr.at(i));
+        rgr.advance(i + 1);
+        return res;
+      }
+    rgr.advance(n);
+  } else {
+    rgr([&](const auto &p) TRANSRANGERS_HOT {
+      if (!pred(*p))
+        return true;
+      res.emplace(p);
+      return false;
+    });
+  }
+  return res;
+}
+
+/**
+ * @brief any_of
+ *
+ * Tells whether some element of `rgr` satisfies `pred`, stopping at the
+ * first one (see `find_if`).
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred
+ * @param rgr
+ * @return bool
+ */
+template <typename Pred, typename Ranger> bool any_of(Pred pred, Ranger rgr) {
+  return find_if(std::move(pred), rgr).has_value();
 }
 
-template <typename Range> struct skip_last_copy {
-  using ranger = decltype(skip_last(std::declval<Range &>()));
-  using cursor = typename ranger::cursor;
+/**
+ * @brief all_of
+ *
+ * Tells whether all the elements of `rgr` satisfy `pred`, stopping at the
+ * first one that does not.
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred
+ * @param rgr
+ * @return bool
+ */
+template <typename Pred, typename Ranger> bool all_of(Pred pred, Ranger rgr) {
+  return !any_of(std::not_fn(std::move(pred)), std::move(rgr));
+}
 
-  template <typename F> auto operator()(const F &p) { return rgr(p); }
+/**
+ * @brief none_of
+ *
+ * Tells whether no element of `rgr` satisfies `pred`, stopping at the first
+ * one that does.
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred
+ * @param rgr
+ * @return bool
+ */
+template <typename Pred, typename Ranger> bool none_of(Pred pred, Ranger rgr) {
+  return !any_of(std::move(pred), std::move(rgr));
+}
 
-  Range rng;
-  ranger rgr = skip_last(rng);
-};
+/**
+ * @brief count_if
+ *
+ * Returns the number of elements of `rgr` satisfying `pred`, adding up the
+ * predicate's results without branching on them. Random-access rangers over
+ * arithmetic values are counted block-wise, as `find_if` scans them;
+ * otherwise, when `TRANSRANGERS_BATCH_WIDTH` is greater than one, elements
+ * are requested in batches (see `batch_consumer`).
+ *
+ * @tparam Pred
+ * @tparam Ranger
+ * @param pred_
+ * @param rgr
+ * @return std::size_t
+ */
+template <typename Pred, typename Ranger>
+std::size_t count_if(Pred pred_, Ranger rgr) {
+  auto pred = pred_box(std::move(pred_));
+  std::size_t n = 0;
+  if constexpr (detail::block_searchable_v<Ranger>) {
+    constexpr auto B = detail::search_block;
+    const auto size = rgr.size();
+    std::size_t i = 0;
+    for (; size - i >= B; i += B) {
+      unsigned m = 0;
+      for (std::size_t l = 0; l < B; ++l)
+        m += static_cast<unsigned>(pred(*rgr.at(i + l)) != 0);
+      n += m;
+    }
+    for (; i < size; ++i)
+      n += pred(*rgr.at(i)) != 0;
+  } else {
+    constexpr auto W = detail::batch_width;
+    rgr(make_exhaustive_consumer(make_batch_consumer<W>([&](const auto &p)
+                                                            TRANSRANGERS_HOT {
+      using arg_type = std::decay_t<decltype(p)>;
+      if constexpr (is_batch<arg_type>::value) {
+        static_assert(arg_type::width <= W);
+        std::size_t m = 0;
+        for (std::size_t l = 0; l < arg_type::width; ++l)
+          m += p.active(l) && pred(p[l]);
+        n += m;
+      } else {
+        n += pred(*p) != 0;
+      }
+      return true;
+    })));
+  }
+  return n;
+}
+
+/**
+ * @brief mismatch
+ *
+ * Walks `rgr1` and `rgr2` in lockstep up to the first pair of elements not
+ * satisfying `eq`, or up to the end of the shorter one, and leaves both
+ * rangers right after the elements returned. The result holds the cursors
+ * to the mismatching pair; when one ranger is a prefix of the other, only
+ * the cursor to the first extra element of the longer one; and nothing when
+ * both have the same elements. As with `find_if`, random-access rangers over
+ * arithmetic values are compared block-wise.
+ *
+ * @tparam Eq
+ * @tparam Ranger1
+ * @tparam Ranger2
+ * @param eq_
+ * @param rgr1
+ * @param rgr2
+ * @return std::pair<std::optional<Ranger1::cursor>,
+ * std::optional<Ranger2::cursor>>
+ */
+template <typename Eq, typename Ranger1, typename Ranger2>
+auto mismatch(Eq eq_, Ranger1 &&rgr1, Ranger2 &&rgr2) {
+  using ranger1 = std::remove_reference_t<Ranger1>;
+  using ranger2 = std::remove_reference_t<Ranger2>;
+  using cursor1 = typename ranger1::cursor;
+  using cursor2 = typename ranger2::cursor;
 
-template <typename Range>
-typename std::enable_if<std::is_rvalue_reference<Range &&>::value,
-                        skip_last_copy<Range>>::type
-skip_last(Range &&rng) {
-  return skip_last_copy<Range>{std::move(rng)};
+  auto eq = pred_box(std::move(eq_));
+  std::pair<std::optional<cursor1>, std::optional<cursor2>> res;
+  if constexpr (detail::block_searchable_v<ranger1> &&
+                detail::block_searchable_v<ranger2>) {
+    constexpr auto B = detail::search_block;
+    const auto n = (std::min)(rgr1.size(), rgr2.size());
+    std::size_t i = 0;
+    for (; n - i >= B; i += B) {
+      unsigned diff = 0;
+      for (std::size_t l = 0; l < B; ++l)
+        diff |=
+            static_cast<unsigned>(eq(*rgr1.at(i + l), *rgr2.at(i + l)) == 0);
+      if (diff)
+        break;
+    }
+    for (; i < n; ++i)
+      if (!eq(*rgr1.at(i), *rgr2.at(i))) {
+        res.first.emplace(rgr1.at(i));
+        res.second.emplace(rgr2.at(i));
+        rgr1.advance(i + 1);
+        rgr2.advance(i + 1);
+        return res;
+      }
+    rgr1.advance(n);
+    rgr2.advance(n);
+    if (rgr1.size() != 0) {
+      res.first.emplace(rgr1.at(0));
+      rgr1.advance(1);
+    } else if (rgr2.size() != 0) {
+      res.second.emplace(rgr2.at(0));
+      rgr2.advance(1);
+    }
+  } else {
+    auto pull2 = [&] {
+      res.second.reset();
+      return detail::pull_into(rgr2, res.second);
+    };
+    bool stopped = false;
+    rgr1([&](const auto &p) TRANSRANGERS_HOT {
+      if (pull2() && eq(*p, **res.second))
+        return true;
+      res.first.emplace(p);
+      stopped = true;
+      return false;
+    });
+    if (!stopped)
+      pull2();
+  }
+  return res;
 }
 
-// skip_first, skip_first_copy (assume the next item is available)
-template <typename Range> auto skip_both(Range &&rng) {
-  using std::begin;
-  using std::end;
-  using cursor = decltype(begin(rng));
+template <typename Ranger1, typename Ranger2>
+auto mismatch(Ranger1 &&rgr1, Ranger2 &&rgr2) {
+  return mismatch(std::equal_to<>{}, std::forward<Ranger1>(rgr1),
+                  std::forward<Ranger2>(rgr2));
+}
 
-  // Sorry, I don't check if the second item is available.
-  return ranger<cursor>([first = ++begin(rng), last = --end(rng)](auto dst)
-                            TRANSRANGERS_HOT_MUTABLE {
-                              auto it = first;
-                              while (it != last)
-                                if (!dst(it++)) {
-                                  first = it;
-                                  return false;
-                                }
-                              return true;
-                            });
+/**
+ * @brief equal
+ *
+ * Tells whether `rgr1` and `rgr2` have the same length and their elements
+ * pairwise satisfy `eq`, stopping at the first mismatch (see `mismatch`).
+ *
+ * @tparam Eq
+ * @tparam Ranger1
+ * @tparam Ranger2
+ * @param eq
+ * @param rgr1
+ * @param rgr2
+ * @return bool
+ */
+template <typename Eq, typename Ranger1, typename Ranger2>
+bool equal(Eq eq, Ranger1 rgr1, Ranger2 rgr2) {
+  auto m = mismatch(std::move(eq), rgr1, rgr2);
+  return !m.first && !m.second;
 }
 
-template <typename Range> struct skip_both_copy {
-  using ranger = decltype(skip_both(std::declval<Range &>()));
-  using cursor = typename ranger::cursor;
+template <typename Ranger1, typename Ranger2>
+bool equal(Ranger1 rgr1, Ranger2 rgr2) {
+  return equal(std::equal_to<>{}, std::move(rgr1), std::move(rgr2));
+}
+
+// make_sink, sinks, fork
+
+/**
+ * @brief sink
+ *
+ * Consumption function with a state, as built by `make_sink`: `s(p)` calls
+ * `f(state, p)`, and `std::move(s).result()` returns the state. Marked
+ * exhaustive (see `exhaustive_consumer`) when `Exhaustive` is `true`, in
+ * which case `f` is assumed to always return `true`.
+ *
+ * @tparam State
+ * @tparam F
+ * @tparam Exhaustive
+ */
+template <typename State, typename F, bool Exhaustive = false> class sink {
+public:
+  static constexpr bool exhaustive = Exhaustive;
+
+  constexpr sink(State st, F f) : st{std::move(st)}, f{std::move(f)} {}
+
+  template <typename Cursor>
+  TRANSRANGERS_HOT constexpr bool operator()(const Cursor &p) {
+    return f(st, p);
+  }
 
-  template <typename F> auto operator()(const F &p) { return rgr(p); }
+  constexpr State result() && { return std::move(st); }
 
-  Range rng;
-  ranger rgr = skip_both(rng);
+private:
+  State st;
+  F f;
 };
 
-template <typename Range>
-typename std::enable_if<std::is_rvalue_reference<Range &&>::value,
-                        skip_both_copy<Range>>::type
-skip_both(Range &&rng) {
-  return skip_both_copy<Range>{std::move(rng)};
+/**
+ * @brief make_sink
+ *
+ * Returns a `sink` with initial state `init` and consumption function
+ * `f(state, p)`, returning `false` to stop.
+ *
+ * @tparam State
+ * @tparam F
+ * @param init
+ * @param f
+ * @return sink<State, F>
+ */
+template <typename State, typename F>
+constexpr auto make_sink(State init, F f) {
+  return sink<State, F>{std::move(init), std::move(f)};
 }
 
 /**
- * @brief Enumerate
+ * @brief make_exhaustive_sink
  *
- * The `enumerate` function is a part of the Transrangers library. It takes a
- * range `rgr` as input and returns a new range where each element is paired
- * with its corresponding index.
+ * Returns an exhaustive `sink` with initial state `init` calling
+ * `f(state, p)` on every element (the return value of `f` is ignored).
+ *
+ * @tparam State
+ * @tparam F
+ * @param init
+ * @param f
+ * @return sink<State, ..., true>
+ */
+template <typename State, typename F>
+constexpr auto make_exhaustive_sink(State init, F f) {
+  auto g = [f = std::move(f)](State &st, const auto &p) TRANSRANGERS_HOT {
+    f(st, p);
+    return true;
+  };
+  return sink<State, decltype(g), true>{std::move(init), std::move(g)};
+}
+
+/* Ready-made sinks for fork. */
+namespace sinks {
+
+template <typename T> constexpr auto accumulate(T init) {
+  return make_exhaustive_sink(std::move(init), [](T &acc, const auto &p) {
+    acc = std::move(acc) + *p;
+  });
+}
+
+constexpr auto count() {
+  return make_exhaustive_sink(std::size_t(0),
+                              [](std::size_t &n, const auto &) { ++n; });
+}
+
+template <typename Pred> constexpr auto count_if(Pred pred) {
+  return make_exhaustive_sink(
+      std::size_t(0), [pred = std::move(pred)](std::size_t &n,
+                                               const auto &p) {
+        n += pred(*p) ? 1 : 0;
+      });
+}
+
+template <typename T> constexpr auto min_max() {
+  return make_exhaustive_sink(
+      std::optional<std::pair<T, T>>{},
+      [](std::optional<std::pair<T, T>> &res, const auto &p) {
+        const T &x = *p;
+        if (!res)
+          res.emplace(x, x);
+        else {
+          res->first = x < res->first ? x : res->first;
+          res->second = res->second < x ? x : res->second;
+        }
+      });
+}
+
+template <typename T> auto to_vector() {
+  return make_exhaustive_sink(std::vector<T>{},
+                              [](std::vector<T> &v, const auto &p) {
+                                v.push_back(*p);
+                              });
+}
+
+} // namespace sinks
+
+namespace detail {
+
+template <typename Sinks, typename Cursor, std::size_t... I>
+TRANSRANGERS_HOT constexpr void fork_push(Sinks &snks, bool *active,
+                                          std::size_t &live, const Cursor &p,
+                                          std::index_sequence<I...>) {
+  (void)((active[I] && !std::get<I>(snks)(p) &&
+          (active[I] = false, --live, true)),
+         ...);
+}
+
+} // namespace detail
+
+/**
+ * @brief fork
+ *
+ * Runs `rgr` once feeding every cursor to each of `snks` (see `make_sink`
+ * and the ready-made `sinks::...`), so that several aggregations share a
+ * single pass over an expensive source. Each element is dereferenced once,
+ * and sinks get a pointer to it as their cursor. A sink returning `false`
+ * is not fed any more, and `rgr` is stopped once all of them have; when
+ * every sink is exhaustive, `rgr` is run with an exhaustive consumer.
  *
  * @tparam Ranger
+ * @tparam Sinks
  * @param rgr
- * @return auto
+ * @param snks
+ * @return std::tuple of the results of `snks`
  */
-template <typename Ranger> auto enumerate(Ranger rgr) {
-  return transform(
-      [index = std::size_t(0)](auto &&value) TRANSRANGERS_HOT_MUTABLE {
-        auto old = index;
-        index += 1;
-        return std::make_pair(old, std::move(value));
-      },
-      rgr);
+template <typename Ranger, typename... Sinks>
+constexpr auto fork(Ranger rgr, Sinks... snks) {
+  static_assert(sizeof...(Sinks) > 0, "fork requires some sink");
+  auto ss = std::tuple<Sinks...>{std::move(snks)...};
+
+  if constexpr ((is_exhaustive_consumer<Sinks>::value && ...)) {
+    rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+      const auto &x = *p;
+      std::apply([q = &x](auto &...s) TRANSRANGERS_HOT { (s(q), ...); }, ss);
+      return true;
+    }));
+  } else {
+    bool active[sizeof...(Sinks)] = {};
+    for (auto &a : active)
+      a = true;
+    auto live = sizeof...(Sinks);
+    rgr([&](const auto &p) TRANSRANGERS_HOT {
+      const auto &x = *p;
+      detail::fork_push(ss, active, live, &x,
+                        std::index_sequence_for<Sinks...>{});
+      return live != 0;
+    });
+  }
+  return std::apply(
+      [](auto &...s) { return std::make_tuple(std::move(s).result()...); },
+      ss);
 }
 
+// tee
+
+namespace detail {
+
+/* Elements of rgr read by the leading branch of a tee and not yet by the
+ * other one, in a ring of capacity (a power of two) slots.
+ */
+template <typename Ranger> struct tee_state {
+  using value_type = cursor_value_t<typename Ranger::cursor>;
+
+  tee_state(Ranger rgr, std::size_t n) : rgr{std::move(rgr)} {
+    while (capacity < n)
+      capacity *= 2;
+    buf.reserve(capacity);
+  }
+
+  /* slots not holding elements yet to be read by some branch */
+  std::size_t room() const {
+    return capacity -
+           static_cast<std::size_t>(produced - (std::min)(pos[0], pos[1]));
+  }
+
+  /* reads up to room() > 0 elements, false if rgr paused without producing
+   * any
+   */
+  bool fill() {
+    auto room = this->room();
+    const auto start = produced;
+    eof = rgr([&](const auto &p) TRANSRANGERS_HOT {
+      const auto i = static_cast<std::size_t>(produced++) & (capacity - 1);
+      if (i < buf.size())
+        buf[i] = *p;
+      else
+        buf.push_back(*p);
+      return --room != 0;
+    });
+    return eof || produced != start;
+  }
+
+  Ranger rgr;
+  std::size_t capacity = 1;
+  std::vector<value_type> buf;
+  std::uint64_t produced = 0, pos[2] = {0, 0};
+  bool eof = false;
+};
+
+} // namespace detail
+
 /**
- * @brief partial sum (cummutative sum)
+ * @brief tee_ranger
  *
- * The `partial_sum` function is a part of the Transrangers library. It takes a
- * range `rgr` and an initial value `init` as input and returns the cumulative
- * sum of the elements in the range.
+ * One of the two rangers returned by `tee`. Cursors are pointers to the
+ * buffered element, valid until either branch is resumed. When this branch
+ * gets `capacity` elements ahead of the other one, it returns `false`
+ * without `dst` having stopped and `stalled()` is `true`: it can be resumed
+ * after the other branch has made progress. If the underlying ranger pauses
+ * without producing an element, so does this branch, with `stalled()`
+ * `false`.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger> class tee_ranger {
+  using state = detail::tee_state<Ranger>;
+
+public:
+  using cursor = const typename state::value_type *;
+
+  tee_ranger(std::shared_ptr<state> st, int side)
+      : st{std::move(st)}, side{side} {}
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    auto &s = *st;
+    auto &pos = s.pos[side];
+    is_stalled = false;
+    for (;;) {
+      while (pos != s.produced) {
+        const auto i = static_cast<std::size_t>(pos++) & (s.capacity - 1);
+        if (!dst(static_cast<cursor>(&s.buf[i])))
+          return false;
+      }
+      if (s.eof)
+        return true;
+      if (s.room() == 0) {
+        is_stalled = true;
+        return false;
+      }
+      if (!s.fill())
+        return false;
+    }
+  }
+
+  bool stalled() const { return is_stalled; }
+
+private:
+  std::shared_ptr<state> st;
+  int side;
+  bool is_stalled = false;
+};
+
+/**
+ * @brief tee
+ *
+ * Returns a pair of rangers over the elements of `rgr`, which is run only
+ * once: elements are copied into a ring of (at least) `capacity` slots
+ * shared by both branches, and their slots reused when both have read
+ * them. The branches can be consumed at different rates, within
+ * `capacity` elements of each other (see `tee_ranger`); for aggregations
+ * consuming everything, `fork` avoids the buffer altogether.
  *
  * @tparam Ranger
- * @tparam T
  * @param rgr
- * @param init
- * @return T
+ * @param capacity
+ * @return std::pair<tee_ranger<Ranger>, tee_ranger<Ranger>>
  */
-template <typename Ranger, typename T> T partial_sum(Ranger rgr, T init) {
-  rgr([&init](const auto &p) TRANSRANGERS_HOT {
-    init = std::move(init) + *p;
-    *p = init;
-    return true;
-  });
-  return init;
+template <typename Ranger> auto tee(Ranger rgr, std::size_t capacity = 1024) {
+  auto st = std::make_shared<detail::tee_state<Ranger>>(std::move(rgr),
+                                                        capacity);
+  return std::pair<tee_ranger<Ranger>, tee_ranger<Ranger>>{
+      tee_ranger<Ranger>{st, 0}, tee_ranger<Ranger>{st, 1}};
 }
 
 /**
@@ -288,8 +2608,45 @@ private:
   std::tuple<Rangers...> rgrs;
 
 public:
-  __lambda_244_25(cursor _zp, const Ranger &_rgr, const Rangers &..._rgrs)
-      : zp{_zp}, rgr{_rgr}, rgrs{_rgrs...} {}
+  __lambda_244_25(cursor _zp, Ranger _rgr, Rangers... _rgrs)
+      : zp{_zp}, rgr{std::move(_rgr)}, rgrs{std::move(_rgrs)...} {}
+};
+
+/**
+ * @brief zip_ranger
+ *
+ * Ranger returned by `zip` when all its inputs are random access (e.g. `all`
+ * over contiguous storage): the common length is computed once and a single
+ * loop over a shared index produces `zip_cursor`s with every column at that
+ * index, instead of resuming each input once per element.
+ *
+ * @tparam Rangers
+ */
+template <typename... Rangers> struct zip_ranger {
+  using cursor = zip_cursor<Rangers...>;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    return detail::run_random_access(*this, size(), dst);
+  }
+
+  std::size_t size() const {
+    return std::apply(
+        [](const auto &...rgrs) { return (std::min)({rgrs.size()...}); }, rgrs);
+  }
+
+  cursor at(std::size_t i) {
+    return std::apply(
+        [i](auto &...rgrs) {
+          return cursor{typename cursor::tuple_type{rgrs.at(i)...}};
+        },
+        rgrs);
+  }
+
+  void advance(std::size_t n) {
+    std::apply([n](auto &...rgrs) { (rgrs.advance(n), ...); }, rgrs);
+  }
+
+  std::tuple<Rangers...> rgrs;
 };
 
 /**
@@ -298,7 +2655,9 @@ public:
  * The `zip` function is a part of the Transrangers library. It takes a range
  * `rgr` and one or more additional ranges `rgrs` as input and returns a new
  * range where each element is a tuple containing the corresponding elements
- * from all the input ranges.
+ * from all the input ranges. If every input is random access, the result is a
+ * `zip_ranger`; otherwise the remaining inputs are resumed for each element
+ * of `rgr`.
  *
  * @tparam Ranger
  * @tparam Rangers
@@ -309,7 +2668,17 @@ public:
 template <typename Ranger, typename... Rangers>
 auto zip(Ranger rgr, Rangers... rgrs) {
   using cursor = zip_cursor<Ranger, Rangers...>;
-  return ranger<cursor>(__lambda_244_25{cursor{}, rgr, rgrs...});
+  if constexpr ((is_random_access_ranger<Ranger>::value && ... &&
+                 is_random_access_ranger<Rangers>::value))
+    return detail::stage(
+        "zip",
+        zip_ranger<Ranger, Rangers...>{{std::move(rgr), std::move(rgrs)...}},
+        rgr, rgrs...);
+  else
+    return detail::stage("zip",
+                         ranger<cursor>(__lambda_244_25<Ranger, Rangers...>{
+                             cursor{}, std::move(rgr), std::move(rgrs)...}),
+                         rgr, rgrs...);
 }
 
 } // namespace transrangers
@@ -0,0 +1,355 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_FUSED_HPP
+#define JOAQUINTIDES_TRANSRANGERS_FUSED_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "transrangers.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
+namespace transrangers {
+
+/* Expression-template mode: fused::all, fused::filter and fused::transform
+ * don't nest rangers but build a flat, typed description of the pipeline
+ * (a source iterator range plus a tuple of stages), merging adjacent
+ * transforms and folding adjacent filters as they go. Sinks (accumulate,
+ * to_vector, for_each) lower the description into a single loop over the
+ * source that applies the stages to each value in order, so no cursor
+ * wrappers, resumption state or per-stage consumption functions are
+ * involved. Fused pipelines are not resumable and work on values rather
+ * than cursors.
+ *
+ *   namespace fused = transrangers::fused;
+ *   auto res = fused::accumulate(
+ *     fused::transform(x3, fused::filter(is_even, fused::all(rng))), 0);
+ */
+
+namespace fused {
+
+template <typename Pred> struct filter_stage {
+  Pred pred;
+};
+
+template <typename F> struct transform_stage {
+  F f;
+};
+
+/**
+ * @brief pipeline
+ *
+ * Description of a fused pipeline: the stages are applied, in order, to
+ * every element of `[first, last)`.
+ *
+ * @tparam Iterator
+ * @tparam Stages
+ */
+template <typename Iterator, typename... Stages> struct pipeline {
+  using iterator = Iterator;
+  using stages_type = std::tuple<Stages...>;
+
+  Iterator first, last;
+  stages_type stages;
+};
+
+namespace detail {
+
+template <typename Stage> struct is_filter_stage : std::false_type {};
+template <typename Pred>
+struct is_filter_stage<filter_stage<Pred>> : std::true_type {};
+
+template <typename Stage> struct is_transform_stage : std::false_type {};
+template <typename F>
+struct is_transform_stage<transform_stage<F>> : std::true_type {};
+
+template <typename... Stages> struct last_stage {
+  using type = void;
+};
+template <typename Stage, typename... Stages>
+struct last_stage<Stage, Stages...> {
+  using type = std::tuple_element_t<sizeof...(Stages),
+                                    std::tuple<Stage, Stages...>>;
+};
+
+/* Like pred_box, but with a non-const call operator so that stateful
+ * predicates held by value can be used.
+ */
+template <typename Pred> struct boxed_pred {
+  template <typename T> int operator()(const T &x) { return pred(x); }
+
+  Pred pred;
+};
+
+template <typename Pred> boxed_pred<Pred> box(Pred pred) {
+  return {std::move(pred)};
+}
+
+/* p(x) && q(x), returned as an int as boxed_pred does */
+template <typename P, typename Q> struct conjunction {
+  template <typename T> int operator()(const T &x) { return p(x) && q(x); }
+
+  P p;
+  Q q;
+};
+
+/* f(g(x)); values that f would return by reference into the temporary g(x)
+ * are returned by copy.
+ */
+template <typename F, typename G> struct composition {
+  template <typename T> decltype(auto) operator()(T &&x) {
+    using inner = decltype(g(std::forward<T>(x)));
+    if constexpr (std::is_reference<inner>::value)
+      return f(g(std::forward<T>(x)));
+    else
+      return std::decay_t<decltype(f(std::declval<inner>()))>(
+          f(g(std::forward<T>(x))));
+  }
+
+  F f;
+  G g;
+};
+
+template <typename Iterator, typename... Stages, typename Stage>
+auto append(pipeline<Iterator, Stages...> pl, Stage stage) {
+  return pipeline<Iterator, Stages..., Stage>{
+      pl.first, pl.last,
+      std::tuple_cat(std::move(pl.stages), std::make_tuple(std::move(stage)))};
+}
+
+template <typename Iterator, typename... Stages, typename Stage,
+          std::size_t... I>
+auto replace_last(pipeline<Iterator, Stages...> pl, Stage stage,
+                  std::index_sequence<I...>) {
+  using stages_type = std::tuple<Stages...>;
+  return pipeline<Iterator, std::tuple_element_t<I, stages_type>..., Stage>{
+      pl.first,
+      pl.last,
+      {std::get<I>(std::move(pl.stages))..., std::move(stage)}};
+}
+
+template <typename Iterator, typename... Stages, typename Stage>
+auto replace_last(pipeline<Iterator, Stages...> pl, Stage stage) {
+  return replace_last(std::move(pl), std::move(stage),
+                      std::make_index_sequence<sizeof...(Stages) - 1>{});
+}
+
+/* value type produced by applying Stages to T */
+template <typename T, typename... Stages> struct output {
+  using type = std::decay_t<T>;
+};
+template <typename T, typename Stage, typename... Stages>
+struct output<T, Stage, Stages...> : output<T, Stages...> {};
+template <typename T, typename F, typename... Stages>
+struct output<T, transform_stage<F>, Stages...>
+    : output<decltype(std::declval<F &>()(std::declval<T>())), Stages...> {};
+
+template <typename Pipeline> struct pipeline_output;
+template <typename Iterator, typename... Stages>
+struct pipeline_output<pipeline<Iterator, Stages...>>
+    : output<decltype(*std::declval<Iterator>()), Stages...> {};
+
+template <std::size_t I, typename StagesTuple, typename T, typename Sink>
+TRANSRANGERS_HOT bool run_stages(StagesTuple &stages, T &&x, Sink &sink) {
+  if constexpr (I == std::tuple_size<StagesTuple>::value)
+    return sink(std::forward<T>(x));
+  else {
+    auto &stage = std::get<I>(stages);
+    if constexpr (is_filter_stage<std::decay_t<decltype(stage)>>::value)
+      return stage.pred(x) ? run_stages<I + 1>(stages, std::forward<T>(x), sink)
+                           : true;
+    else
+      return run_stages<I + 1>(stages, stage.f(std::forward<T>(x)), sink);
+  }
+}
+
+/* The single loop every fused sink lowers to. sink returns false to stop. */
+template <typename Pipeline, typename Sink>
+TRANSRANGERS_HOT void run(Pipeline &pl, Sink &sink) {
+  for (auto it = pl.first, last = pl.last; it != last; ++it)
+    if (!run_stages<0>(pl.stages, *it, sink))
+      return;
+}
+
+} // namespace detail
+
+/**
+ * @brief all
+ *
+ * Starts a fused pipeline over `rng`, which must outlive it.
+ *
+ * @tparam Range
+ * @param rng
+ * @return pipeline<iterator of Range>
+ */
+template <typename Range> auto all(Range &rng) {
+  using std::begin;
+  using std::end;
+  using iterator = decltype(begin(rng));
+
+  return pipeline<iterator>{begin(rng), end(rng), {}};
+}
+
+/**
+ * @brief filter
+ *
+ * Appends a filtering stage to `pl`. `filter(p, filter(q, pl))` becomes a
+ * single stage testing `q` and then `p`.
+ *
+ * @tparam Pred
+ * @tparam Iterator
+ * @tparam Stages
+ * @param pred
+ * @param pl
+ * @return auto
+ */
+template <typename Pred, typename Iterator, typename... Stages>
+auto filter(Pred pred, pipeline<Iterator, Stages...> pl) {
+  using last = typename detail::last_stage<Stages...>::type;
+
+  /* boxing works around the same auto-vectorization issue as pred_box in
+   * transrangers::filter.
+   */
+  if constexpr (detail::is_filter_stage<last>::value) {
+    auto q = std::move(std::get<sizeof...(Stages) - 1>(pl.stages).pred);
+    auto p = detail::box(std::move(pred));
+    using pq_type = detail::conjunction<decltype(q), decltype(p)>;
+    return detail::replace_last(
+        std::move(pl),
+        filter_stage<pq_type>{pq_type{std::move(q), std::move(p)}});
+  } else {
+    auto p = detail::box(std::move(pred));
+    return detail::append(std::move(pl),
+                          filter_stage<decltype(p)>{std::move(p)});
+  }
+}
+
+/**
+ * @brief transform
+ *
+ * Appends a transformation stage to `pl`. `transform(f, transform(g, pl))`
+ * becomes a single stage computing `f(g(x))`.
+ *
+ * @tparam F
+ * @tparam Iterator
+ * @tparam Stages
+ * @param f
+ * @param pl
+ * @return auto
+ */
+template <typename F, typename Iterator, typename... Stages>
+auto transform(F f, pipeline<Iterator, Stages...> pl) {
+  using last = typename detail::last_stage<Stages...>::type;
+
+  if constexpr (detail::is_transform_stage<last>::value) {
+    auto g = std::move(std::get<sizeof...(Stages) - 1>(pl.stages).f);
+    return detail::replace_last(
+        std::move(pl), transform_stage<detail::composition<F, decltype(g)>>{
+                           {std::move(f), std::move(g)}});
+  } else
+    return detail::append(std::move(pl), transform_stage<F>{std::move(f)});
+}
+
+/**
+ * @brief accumulate
+ *
+ * @tparam Iterator
+ * @tparam Stages
+ * @tparam T
+ * @param pl
+ * @param init
+ * @return T
+ */
+template <typename Iterator, typename... Stages, typename T>
+T accumulate(pipeline<Iterator, Stages...> pl, T init) {
+  auto sink = [&](auto &&x) TRANSRANGERS_HOT {
+    init = std::move(init) + std::forward<decltype(x)>(x);
+    return true;
+  };
+  detail::run(pl, sink);
+  return init;
+}
+
+/**
+ * @brief to_vector
+ *
+ * Returns a `std::vector` with the output of `pl`. Over random-access
+ * sources the input size is reserved (exactly if `pl` has no filter stage,
+ * as an upper bound otherwise).
+ *
+ * @tparam Iterator
+ * @tparam Stages
+ * @param pl
+ * @return std::vector<output value type of pl>
+ */
+template <typename Iterator, typename... Stages>
+auto to_vector(pipeline<Iterator, Stages...> pl) {
+  using value_type = typename detail::pipeline_output<
+      pipeline<Iterator, Stages...>>::type;
+
+  std::vector<value_type> v;
+  if constexpr (transrangers::detail::is_random_access<Iterator>::value)
+    v.reserve(static_cast<std::size_t>(pl.last - pl.first));
+  auto sink = [&](auto &&x) TRANSRANGERS_HOT {
+    v.push_back(std::forward<decltype(x)>(x));
+    return true;
+  };
+  detail::run(pl, sink);
+  return v;
+}
+
+/**
+ * @brief for_each
+ *
+ * Calls `f` with every output value of `pl` and returns `f`.
+ *
+ * @tparam Iterator
+ * @tparam Stages
+ * @tparam F
+ * @param pl
+ * @param f
+ * @return F
+ */
+template <typename Iterator, typename... Stages, typename F>
+F for_each(pipeline<Iterator, Stages...> pl, F f) {
+  auto sink = [&](auto &&x) TRANSRANGERS_HOT {
+    f(std::forward<decltype(x)>(x));
+    return true;
+  };
+  detail::run(pl, sink);
+  return f;
+}
+
+} // namespace fused
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
+#endif
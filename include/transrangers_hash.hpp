@@ -0,0 +1,434 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_HASH_HPP
+#define JOAQUINTIDES_TRANSRANGERS_HASH_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "transrangers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) ||              \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSRANGERS_FLAT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
+namespace transrangers {
+
+namespace detail::flat {
+
+/* Control bytes: 0x80 marks an empty slot, 0..0x7F the 7 low bits of the
+ * hash of the element in a full one. Slots are probed in groups of 16 whose
+ * control bytes are matched at once.
+ */
+constexpr std::size_t group_size = 16;
+constexpr unsigned char empty = 0x80;
+
+inline unsigned match(const unsigned char *ctrl, unsigned char h) {
+#if defined(TRANSRANGERS_FLAT_SSE2)
+  auto c = _mm_load_si128(reinterpret_cast<const __m128i *>(ctrl));
+  return static_cast<unsigned>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(static_cast<char>(h)))));
+#else
+  unsigned m = 0;
+  for (std::size_t i = 0; i < group_size; ++i)
+    m |= static_cast<unsigned>(ctrl[i] == h) << i;
+  return m;
+#endif
+}
+
+inline unsigned match_empty(const unsigned char *ctrl) {
+#if defined(TRANSRANGERS_FLAT_SSE2)
+  return static_cast<unsigned>(_mm_movemask_epi8(
+      _mm_load_si128(reinterpret_cast<const __m128i *>(ctrl))));
+#else
+  return match(ctrl, empty);
+#endif
+}
+
+inline unsigned first_bit(unsigned m) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctz(m));
+#else
+  unsigned i = 0;
+  for (; !(m & 1); m >>= 1)
+    ++i;
+  return i;
+#endif
+}
+
+inline std::uint64_t mix(std::size_t h) {
+  /* std::hash is the identity for integers on common implementations */
+  auto x = static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+  return x ^ (x >> 32);
+}
+
+struct identity_key {
+  template <typename T> const T &operator()(const T &x) const { return x; }
+};
+
+/**
+ * @brief flat_table
+ *
+ * Open-addressing hash table of `Value`s with `KeyOf` extracting their keys,
+ * allocating a single block from a `std::pmr::memory_resource`. Elements are
+ * never erased individually; `clear` keeps the block for reuse.
+ *
+ * @tparam Key
+ * @tparam Value
+ * @tparam KeyOf
+ * @tparam Hash
+ * @tparam Eq
+ */
+template <typename Key, typename Value = Key, typename KeyOf = identity_key,
+          typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>>
+class flat_table {
+public:
+  explicit flat_table(
+      std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+      : mr{mr} {}
+
+  flat_table(const flat_table &x) : mr{x.mr} {
+    reserve(x.count);
+    x.for_each([&](const Value &v) { insert_new(hash(KeyOf()(v)), v); });
+  }
+
+  flat_table(flat_table &&x) noexcept
+      : mr{x.mr}, ctrl{x.ctrl}, slots{x.slots}, ngroups{x.ngroups},
+        count{x.count} {
+    x.ctrl = nullptr;
+    x.slots = nullptr;
+    x.ngroups = x.count = 0;
+  }
+
+  flat_table &operator=(const flat_table &) = delete;
+
+  ~flat_table() {
+    clear();
+    release();
+  }
+
+  std::size_t size() const { return count; }
+  std::size_t capacity() const { return ngroups * group_size * 7 / 8; }
+
+  /* room for n elements without rehashing */
+  void reserve(std::size_t n) {
+    if (n <= capacity())
+      return;
+    auto g = std::size_t(1);
+    while (g * group_size * 7 / 8 < n)
+      g *= 2;
+    rehash(g);
+  }
+
+  template <typename K> Value *find(const K &k) {
+    if (!ngroups)
+      return nullptr;
+    auto h = hash(k);
+    for (auto g = h >> 7, i = std::uint64_t(0);; g += ++i) {
+      auto base = static_cast<std::size_t>(g & (ngroups - 1)) * group_size;
+      for (auto m = match(ctrl + base, h & 0x7F); m; m &= m - 1) {
+        auto &v = slots[base + first_bit(m)];
+        if (Eq()(KeyOf()(v), k))
+          return &v;
+      }
+      if (match_empty(ctrl + base))
+        return nullptr;
+    }
+  }
+
+  /* Value constructed from args... if no element has key k */
+  template <typename... Args>
+  std::pair<Value *, bool> try_emplace(const Key &k, Args &&...args) {
+    if (auto p = find(k))
+      return {p, false};
+    if (count + 1 > capacity())
+      rehash(ngroups ? ngroups * 2 : 1);
+    return {insert_new(hash(k), std::forward<Args>(args)...), true};
+  }
+
+  void clear() {
+    for_each([](Value &v) { v.~Value(); });
+    for (std::size_t i = 0; i < ngroups * group_size; ++i)
+      ctrl[i] = empty;
+    count = 0;
+  }
+
+private:
+  template <typename K> std::uint64_t hash(const K &k) const {
+    return mix(Hash()(k));
+  }
+
+  template <typename F> void for_each(F f) const {
+    for (std::size_t i = 0; i < ngroups * group_size; ++i)
+      if (ctrl[i] != empty)
+        f(slots[i]);
+  }
+
+  template <typename... Args>
+  Value *insert_new(std::uint64_t h, Args &&...args) {
+    for (auto g = h >> 7, i = std::uint64_t(0);; g += ++i) {
+      auto base = static_cast<std::size_t>(g & (ngroups - 1)) * group_size;
+      if (auto m = match_empty(ctrl + base)) {
+        auto j = base + first_bit(m);
+        auto p = ::new (static_cast<void *>(slots + j))
+            Value(std::forward<Args>(args)...);
+        ctrl[j] = static_cast<unsigned char>(h & 0x7F);
+        ++count;
+        return p;
+      }
+    }
+  }
+
+  static std::size_t ctrl_bytes(std::size_t g) {
+    auto n = g * group_size;
+    return (n + alignof(Value) - 1) / alignof(Value) * alignof(Value);
+  }
+  static std::size_t block_bytes(std::size_t g) {
+    return ctrl_bytes(g) + g * group_size * sizeof(Value);
+  }
+  static constexpr std::size_t block_align =
+      alignof(Value) > group_size ? alignof(Value) : group_size;
+
+  void rehash(std::size_t g) {
+    auto block =
+        static_cast<unsigned char *>(mr->allocate(block_bytes(g), block_align));
+    auto old = flat_table{mr};
+    old.ctrl = ctrl;
+    old.slots = slots;
+    old.ngroups = ngroups;
+    old.count = count;
+    ctrl = block;
+    slots = reinterpret_cast<Value *>(block + ctrl_bytes(g));
+    ngroups = g;
+    count = 0;
+    for (std::size_t i = 0; i < g * group_size; ++i)
+      ctrl[i] = empty;
+    old.for_each([&](Value &v) {
+      insert_new(hash(KeyOf()(v)), std::move(v));
+    });
+  }
+
+  void release() {
+    if (ctrl)
+      mr->deallocate(ctrl, block_bytes(ngroups), block_align);
+  }
+
+  std::pmr::memory_resource *mr;
+  unsigned char *ctrl = nullptr;
+  Value *slots = nullptr;
+  std::size_t ngroups = 0, count = 0;
+};
+
+/* build side of hash_join: the elements with a given key, in insertion
+ * order, are linked through next[] starting at first
+ */
+template <typename Key> struct join_entry {
+  Key key;
+  std::size_t first, last;
+};
+
+struct join_entry_key {
+  template <typename Key> const Key &operator()(const join_entry<Key> &e) const {
+    return e.key;
+  }
+};
+
+constexpr std::size_t npos = std::size_t(-1);
+
+} // namespace detail::flat
+
+/**
+ * @brief distinct
+ *
+ * Ranger over the elements of `rgr` not equal to any previous one, in their
+ * original order (`unique` only drops adjacent duplicates). The elements seen
+ * are kept in an open-addressing hash table allocated from `mr`, presized
+ * from the size hint of `rgr` if it has one. A pooling resource (e.g.
+ * `std::pmr::unsynchronized_pool_resource`) shared across calls lets repeated
+ * invocations run without going to the system allocator.
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @param mr
+ * @return auto
+ */
+template <typename Ranger>
+auto distinct(Ranger rgr, std::pmr::memory_resource *mr =
+                              std::pmr::get_default_resource()) {
+  using cursor = typename Ranger::cursor;
+  using value_type = std::decay_t<decltype(*std::declval<const cursor &>())>;
+  using table = detail::flat::flat_table<value_type>;
+
+  auto hint = detail::hint_of(rgr);
+  auto res = detail::ranger_hinted_by<cursor>(
+      hint, [rgr = std::move(rgr), seen = table{mr},
+             start = true](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        if (start) {
+          start = false;
+          if constexpr (has_size_hint<Ranger>::value)
+            seen.reserve(detail::size_hint(rgr));
+        }
+        return rgr(detail::exhaustive_like<decltype(dst)>(
+            [&](const auto &p) TRANSRANGERS_HOT {
+              decltype(auto) x = *p;
+              return !seen.try_emplace(x, x).second || dst(p);
+            }));
+      });
+  return detail::stage("distinct", std::move(res), rgr);
+}
+
+/**
+ * @brief hash_join_cursor
+ *
+ * Cursor of `hash_join`, dereferencing to a `std::pair` of the build element
+ * and the probe element.
+ *
+ * @tparam Build
+ * @tparam ProbeCursor
+ */
+template <typename Build, typename ProbeCursor> struct hash_join_cursor {
+  auto operator*() const {
+    return std::pair<const Build &, decltype(*p)>{*b, *p};
+  }
+
+  const Build *b;
+  ProbeCursor p;
+};
+
+/**
+ * @brief hash_join
+ *
+ * Inner equijoin of `build_rgr` and `probe_rgr` on `key_build(x) ==
+ * key_probe(y)`. On first invocation the elements of `build_rgr` are copied
+ * into a vector and indexed by key in an open-addressing hash table, both
+ * allocated from `mr` and presized if `build_rgr` has a size hint; then for
+ * each element of `probe_rgr`, the matching build elements are produced in
+ * their original order. Probe keys are converted to the key type of the
+ * build side.
+ *
+ * @tparam BuildRanger
+ * @tparam ProbeRanger
+ * @tparam KeyBuild
+ * @tparam KeyProbe
+ * @param build_rgr
+ * @param probe_rgr
+ * @param key_build
+ * @param key_probe
+ * @param mr
+ * @return auto
+ */
+template <typename BuildRanger, typename ProbeRanger, typename KeyBuild,
+          typename KeyProbe>
+auto hash_join(
+    BuildRanger build_rgr, ProbeRanger probe_rgr, KeyBuild key_build,
+    KeyProbe key_probe,
+    std::pmr::memory_resource *mr = std::pmr::get_default_resource()) {
+  using build_cursor = typename BuildRanger::cursor;
+  using probe_cursor = typename ProbeRanger::cursor;
+  using build_type =
+      std::decay_t<decltype(*std::declval<const build_cursor &>())>;
+  using key_type = std::decay_t<decltype(key_build(
+      std::declval<const build_type &>()))>;
+  using entry = detail::flat::join_entry<key_type>;
+  using table = detail::flat::flat_table<key_type, entry,
+                                         detail::flat::join_entry_key>;
+  using cursor = hash_join_cursor<build_type, probe_cursor>;
+
+  auto res = ranger<cursor>(
+      [build_rgr = std::move(build_rgr), probe_rgr = std::move(probe_rgr),
+       key_build = std::move(key_build), key_probe = std::move(key_probe),
+       built = false, done = false, index = table{mr},
+       elements = std::pmr::vector<build_type>{mr},
+       next = std::pmr::vector<std::size_t>{mr}, pending = probe_cursor{},
+       i = detail::flat::npos](auto dst) TRANSRANGERS_HOT_MUTABLE {
+        if (!built) {
+          built = true;
+          if constexpr (has_size_hint<BuildRanger>::value) {
+            auto n = detail::size_hint(build_rgr);
+            index.reserve(n);
+            elements.reserve(n);
+            next.reserve(n);
+          }
+          build_rgr(make_exhaustive_consumer([&](const auto &p) {
+            auto j = elements.size();
+            elements.push_back(*p);
+            next.push_back(detail::flat::npos);
+            auto [e, inserted] =
+                index.try_emplace(key_build(elements.back()),
+                                  entry{key_build(elements.back()), j, j});
+            if (!inserted) {
+              next[e->last] = j;
+              e->last = j;
+            }
+            return true;
+          }));
+        }
+        /* matches of the probe element dst stopped at */
+        while (i != detail::flat::npos) {
+          auto c = cursor{&elements[i], pending};
+          i = next[i];
+          if (!dst(c))
+            return false;
+        }
+        if (done)
+          return true;
+        if (!probe_rgr([&](const auto &p) TRANSRANGERS_HOT {
+              auto e = index.find(key_type(key_probe(*p)));
+              if (!e)
+                return true;
+              for (auto j = e->first; j != detail::flat::npos;) {
+                auto c = cursor{&elements[j], p};
+                j = next[j];
+                if (!dst(c)) {
+                  pending = p;
+                  i = j;
+                  return false;
+                }
+              }
+              return true;
+            }))
+          return false;
+        done = true;
+        return true;
+      });
+  return detail::stage("hash_join", std::move(res), build_rgr, probe_rgr);
+}
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
+#undef TRANSRANGERS_FLAT_SSE2
+#endif
@@ -0,0 +1,255 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_IO_HPP
+#define JOAQUINTIDES_TRANSRANGERS_IO_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "transrangers.hpp"
+
+#if !__has_include(<sys/mman.h>)
+#error "transrangers_io.hpp requires a POSIX system"
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
+namespace transrangers {
+
+/* Source rangers over files. mmap_lines and mmap_records map the file
+ * read-only and yield cursors pointing straight into the mapped pages; the
+ * mapping is shared by all copies of the ranger and released with the last
+ * one. Errors are reported by throwing std::system_error.
+ */
+
+namespace detail::io {
+
+[[noreturn]] inline void throw_errno(const char *what, const std::string &arg) {
+  throw std::system_error(errno, std::generic_category(),
+                          std::string("transrangers: ") + what + " " + arg);
+}
+
+/* Read-only, sequentially advised mapping of a whole file. */
+class mapping {
+public:
+  explicit mapping(const std::string &path) {
+    int fd;
+    do
+      fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    while (fd < 0 && errno == EINTR);
+    if (fd < 0)
+      throw_errno("open", path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      auto e = errno;
+      ::close(fd);
+      errno = e;
+      throw_errno("fstat", path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ != 0) {
+      auto p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        auto e = errno;
+        ::close(fd);
+        errno = e;
+        throw_errno("mmap", path);
+      }
+      data_ = static_cast<const char *>(p);
+      ::madvise(p, size_, MADV_SEQUENTIAL); /* advisory, errors ignored */
+    }
+    ::close(fd);
+  }
+
+  mapping(const mapping &) = delete;
+  mapping &operator=(const mapping &) = delete;
+
+  ~mapping() {
+    if (data_)
+      ::munmap(const_cast<char *>(data_), size_);
+  }
+
+  const char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+} // namespace detail::io
+
+/**
+ * @brief string_view_cursor
+ *
+ * Cursor dereferencing to a `std::string_view` (a line, a chunk).
+ */
+struct string_view_cursor {
+  std::string_view operator*() const { return v; }
+
+  std::string_view v;
+};
+
+/**
+ * @brief lines_ranger
+ *
+ * Ranger returned by `mmap_lines`. Like `all`, it remembers the position
+ * after the last line consumed, so it resumes correctly after an early stop.
+ */
+struct lines_ranger {
+  using cursor = string_view_cursor;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    auto it = first;
+    while (it != last) {
+      auto nl = static_cast<const char *>(
+          std::memchr(it, '\n', static_cast<std::size_t>(last - it)));
+      auto e = nl ? nl : last;
+      cursor p{std::string_view(it, static_cast<std::size_t>(e - it))};
+      it = nl ? nl + 1 : last;
+      if (!dst(p)) {
+        first = it;
+        return false;
+      }
+    }
+    first = last;
+    return true;
+  }
+
+  std::shared_ptr<const detail::io::mapping> map;
+  const char *first, *last;
+};
+
+/**
+ * @brief mmap_lines
+ *
+ * Returns a ranger over the lines of the file at `path`, as
+ * `std::string_view`s into the mapped file excluding the terminating `'\n'`.
+ * A final line without terminator is included; no empty line is produced
+ * after a final `'\n'`.
+ *
+ * @param path
+ * @return lines_ranger
+ */
+inline lines_ranger mmap_lines(const std::string &path) {
+  auto map = std::make_shared<const detail::io::mapping>(path);
+  auto first = map->data(), last = first + map->size();
+  return {std::move(map), first, last};
+}
+
+/**
+ * @brief records_ranger
+ *
+ * Ranger returned by `mmap_records`: an `all_ranger` over the records in the
+ * mapped file (hence random access) that keeps the mapping alive.
+ *
+ * @tparam T
+ */
+template <typename T> struct records_ranger : all_ranger<const T *> {
+  std::shared_ptr<const detail::io::mapping> map;
+};
+
+/**
+ * @brief mmap_records
+ *
+ * Returns a ranger over the file at `path` seen as an array of `T`s, with
+ * cursors `const T*` into the mapped file. A trailing partial record is
+ * ignored.
+ *
+ * @tparam T trivially copyable record type
+ * @param path
+ * @return records_ranger<T>
+ */
+template <typename T> records_ranger<T> mmap_records(const std::string &path) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "records must be trivially copyable");
+
+  auto map = std::make_shared<const detail::io::mapping>(path);
+  auto first = reinterpret_cast<const T *>(map->data());
+  auto last = first + map->size() / sizeof(T);
+  return {{first, last}, std::move(map)};
+}
+
+/**
+ * @brief fd_chunks_ranger
+ *
+ * Ranger returned by `fd_chunks`. Each chunk is read into a buffer shared by
+ * all copies of the ranger, so a cursor stays valid only until the ranger is
+ * resumed.
+ */
+struct fd_chunks_ranger {
+  using cursor = string_view_cursor;
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    for (;;) {
+      ::ssize_t n;
+      do
+        n = ::read(fd, buf->data(), buf->size());
+      while (n < 0 && errno == EINTR);
+      if (n < 0)
+        detail::io::throw_errno("read", "fd " + std::to_string(fd));
+      if (n == 0)
+        return true;
+      if (!dst(cursor{std::string_view(buf->data(),
+                                        static_cast<std::size_t>(n))}))
+        return false;
+    }
+  }
+
+  int fd;
+  std::shared_ptr<std::vector<char>> buf;
+};
+
+/**
+ * @brief fd_chunks
+ *
+ * Returns a ranger over the data read from `fd` (a pipe, socket or file, not
+ * owned by the ranger) in chunks of at most `chunk_size` bytes, for inputs
+ * that can't be mapped.
+ *
+ * @param fd
+ * @param chunk_size
+ * @return fd_chunks_ranger
+ */
+inline fd_chunks_ranger fd_chunks(int fd, std::size_t chunk_size = 64 * 1024) {
+  return {fd, std::make_shared<std::vector<char>>(chunk_size ? chunk_size : 1)};
+}
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
+#endif
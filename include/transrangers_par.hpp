@@ -0,0 +1,1145 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_PAR_HPP
+#define JOAQUINTIDES_TRANSRANGERS_PAR_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "transrangers.hpp"
+#include "transrangers_ext.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__clang__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE __attribute__((flatten)) mutable
+#elif defined(__GNUC__)
+#define TRANSRANGERS_HOT __attribute__((flatten))
+#define TRANSRANGERS_HOT_MUTABLE mutable __attribute__((flatten))
+#else
+#define TRANSRANGERS_HOT [[msvc::forceinline]]
+#define TRANSRANGERS_HOT_MUTABLE mutable [[msvc::forceinline]]
+#endif
+
+/* Default amount of input memory processed by a single parallel task. Sized
+ * after a typical L2 cache so that each chunk stays cache-resident while the
+ * whole pipeline runs over it.
+ */
+#if !defined(TRANSRANGERS_PAR_CHUNK_BYTES)
+#define TRANSRANGERS_PAR_CHUNK_BYTES (256 * 1024)
+#endif
+
+/* Maximum number of elements handed over at a time between the threads of a
+ * pipeline stage.
+ */
+#if !defined(TRANSRANGERS_PIPELINE_BATCH)
+#define TRANSRANGERS_PIPELINE_BATCH 256
+#endif
+
+namespace transrangers {
+
+/**
+ * @brief par_policy
+ *
+ * Execution policy for the parallel sources and sinks. `threads` is the
+ * maximum number of threads (the calling one included) working on a single
+ * call, `0` meaning as many as the hardware supports. `chunk_size` is the
+ * number of input elements per task, `0` meaning roughly
+ * `TRANSRANGERS_PAR_CHUNK_BYTES` worth of elements.
+ */
+struct par_policy {
+  std::size_t threads = 0;
+  std::size_t chunk_size = 0;
+};
+
+namespace detail::par {
+
+/**
+ * @brief thread_pool
+ *
+ * Process-wide pool of worker threads executing one indexed job at a time.
+ * Task indices are handed out through a shared atomic counter, so idle
+ * threads keep grabbing the next pending chunk until none is left: for a flat
+ * index space this gives the same load balancing as per-thread deques with
+ * stealing, at a fraction of the bookkeeping. The calling thread always takes
+ * part in the job. Calls issued while the pool is busy (including nested calls
+ * from inside a task) are executed inline by the calling thread.
+ */
+class thread_pool {
+public:
+  explicit thread_pool(std::size_t num_workers) {
+    workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i)
+      workers.emplace_back([this] { work(); });
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lk{mtx};
+      stopping = true;
+    }
+    cv.notify_all();
+    for (auto &w : workers)
+      w.join();
+  }
+
+  static thread_pool &instance() {
+    static thread_pool pool{std::max(std::thread::hardware_concurrency(), 1u) -
+                            1};
+    return pool;
+  }
+
+  std::size_t size() const { return workers.size() + 1; }
+
+  /* Calls f(i) for every i in [0, n) on at most `width` threads, blocks until
+   * all calls are done and rethrows the first exception thrown by f, if any.
+   */
+  template <typename F> void run(std::size_t n, std::size_t width, F &f) {
+    if (in_worker() || width <= 1 || n <= 1 || workers.empty() ||
+        busy.exchange(true, std::memory_order_acquire)) {
+      for (std::size_t i = 0; i < n; ++i)
+        f(i);
+      return;
+    }
+    struct release {
+      ~release() { b.store(false, std::memory_order_release); }
+      std::atomic<bool> &b;
+    } r{busy};
+
+    job j;
+    j.invoke = [](void *ctx, std::size_t i) { (*static_cast<F *>(ctx))(i); };
+    j.ctx = &f;
+    j.n = n;
+    j.seats = std::min(width, n) - 1;
+    {
+      std::lock_guard<std::mutex> lk{mtx};
+      current = &j;
+      ++generation;
+    }
+    cv.notify_all();
+    j.drain();
+    {
+      std::unique_lock<std::mutex> lk{mtx};
+      current = nullptr; /* no more workers can join */
+      done_cv.wait(lk, [&] { return j.active == 0; });
+    }
+    if (j.error)
+      std::rethrow_exception(j.error);
+  }
+
+private:
+  struct job {
+    void drain() {
+      for (;;) {
+        auto i = next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= n || failed.load(std::memory_order_relaxed))
+          return;
+        try {
+          invoke(ctx, i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lk{error_mtx};
+          if (!error)
+            error = std::current_exception();
+          failed.store(true, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    void (*invoke)(void *, std::size_t) = nullptr;
+    void *ctx = nullptr;
+    std::size_t n = 0;
+    std::size_t seats = 0;  /* guarded by thread_pool::mtx */
+    std::size_t active = 0; /* guarded by thread_pool::mtx */
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex error_mtx;
+    std::exception_ptr error;
+  };
+
+  static bool &in_worker() {
+    static thread_local bool flag = false;
+    return flag;
+  }
+
+  void work() {
+    in_worker() = true;
+    std::size_t seen = 0;
+    std::unique_lock<std::mutex> lk{mtx};
+    for (;;) {
+      cv.wait(lk, [&] { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+      auto *j = current;
+      if (!j || j->seats == 0)
+        continue;
+      --j->seats;
+      ++j->active;
+      lk.unlock();
+      j->drain();
+      lk.lock();
+      if (--j->active == 0)
+        done_cv.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::atomic<bool> busy{false};
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::condition_variable done_cv;
+  job *current = nullptr;
+  std::size_t generation = 0;
+  bool stopping = false;
+};
+
+template <typename Iterator> struct subrange {
+  Iterator begin() const { return first; }
+  Iterator end() const { return last; }
+
+  Iterator first, last;
+};
+
+} // namespace detail::par
+
+/**
+ * @brief par_source
+ *
+ * Random-access input split into chunks by the parallel sinks. Each chunk is
+ * exposed to the user-supplied pipeline as `all(chunk)`.
+ *
+ * @tparam Iterator
+ */
+template <typename Iterator> struct par_source {
+  static_assert(
+      std::is_base_of<
+          std::random_access_iterator_tag,
+          typename std::iterator_traits<Iterator>::iterator_category>::value,
+      "par_all requires a random-access range");
+
+  using value_type = typename std::iterator_traits<Iterator>::value_type;
+
+  std::size_t size() const { return static_cast<std::size_t>(last - first); }
+
+  std::size_t chunk_size() const {
+    if (policy.chunk_size)
+      return policy.chunk_size;
+    return std::max<std::size_t>(TRANSRANGERS_PAR_CHUNK_BYTES /
+                                     std::max<std::size_t>(sizeof(value_type),
+                                                           1),
+                                 1);
+  }
+
+  std::size_t num_chunks() const {
+    auto cs = chunk_size();
+    return (size() + cs - 1) / cs;
+  }
+
+  std::size_t num_threads() const {
+    return policy.threads ? policy.threads
+                          : detail::par::thread_pool::instance().size();
+  }
+
+  auto chunk(std::size_t i) const {
+    auto cs = chunk_size();
+    auto b = first + static_cast<std::ptrdiff_t>(i * cs);
+    auto e = first + static_cast<std::ptrdiff_t>(std::min(size(), (i + 1) * cs));
+    return detail::par::subrange<Iterator>{b, e};
+  }
+
+  Iterator first, last;
+  par_policy policy;
+};
+
+/**
+ * @brief par_all
+ *
+ * Parallel counterpart of `all`: returns a description of the random-access
+ * range `rng` to be consumed by `par_accumulate`, `par_reduce` or
+ * `par_for_each`. The range must outlive the parallel call.
+ *
+ * @tparam Range
+ * @param rng
+ * @param policy
+ * @return par_source
+ */
+template <typename Range> auto par_all(Range &rng, par_policy policy = {}) {
+  using std::begin;
+  using std::end;
+  using iterator = decltype(begin(rng));
+
+  return par_source<iterator>{begin(rng), end(rng), policy};
+}
+
+namespace detail::par {
+
+struct identity_pipeline {
+  template <typename Ranger> Ranger operator()(Ranger rgr) const {
+    return rgr;
+  }
+};
+
+/* Runs f(chunk_index, chunk_ranger) for every chunk of src, where
+ * chunk_ranger is pipeline applied to all() over the chunk.
+ */
+template <typename Iterator, typename Pipeline, typename F>
+void for_each_chunk(const par_source<Iterator> &src, Pipeline &pipeline,
+                    F f) {
+  auto task = [&](std::size_t i) {
+    auto rng = src.chunk(i);
+    f(i, pipeline(all(rng)));
+  };
+  thread_pool::instance().run(src.num_chunks(), src.num_threads(), task);
+}
+
+} // namespace detail::par
+
+/**
+ * @brief par_reduce
+ *
+ * Runs `pipeline(all(chunk))` over every chunk of `src` in parallel, folds
+ * each chunk with the associative operation `op` and combines the chunk
+ * results, in input order, into `init`. `take` and other adaptors stopping
+ * early inside `pipeline` apply per chunk and don't cancel the other chunks,
+ * so `take(n, rgr)` keeps up to `n` elements of every chunk and the result
+ * differs from the serial one; use `par_for_each`, or apply such adaptors to
+ * a serial source.
+ *
+ * @tparam Iterator
+ * @tparam Pipeline
+ * @tparam T
+ * @tparam Op
+ * @param src
+ * @param pipeline callable mapping a ranger over a chunk to the final ranger
+ * @param init
+ * @param op associative binary operation
+ * @return T
+ */
+template <typename Iterator, typename Pipeline, typename T, typename Op>
+T par_reduce(const par_source<Iterator> &src, Pipeline pipeline, T init,
+             Op op) {
+  std::vector<std::optional<T>> partials(src.num_chunks());
+
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    auto &acc = partials[i];
+    if (rgr([&](const auto &p) TRANSRANGERS_HOT {
+          acc.emplace(*p);
+          return false;
+        }))
+      return;
+    rgr(make_exhaustive_consumer([&, &x = *acc](const auto &p)
+                                     TRANSRANGERS_HOT {
+      x = op(std::move(x), *p);
+      return true;
+    }));
+  });
+  for (auto &x : partials)
+    if (x)
+      init = op(std::move(init), std::move(*x));
+  return init;
+}
+
+template <typename Iterator, typename T, typename Op>
+T par_reduce(const par_source<Iterator> &src, T init, Op op) {
+  return par_reduce(src, detail::par::identity_pipeline{}, std::move(init),
+                    std::move(op));
+}
+
+/**
+ * @brief par_accumulate
+ *
+ * Parallel `accumulate`: every chunk is summed starting from `T{}`, which must
+ * be the identity of `+`, and the partial sums are added to `init` in input
+ * order. As with `par_reduce`, early-stopping adaptors such as `take` inside
+ * `pipeline` apply per chunk.
+ *
+ * @tparam Iterator
+ * @tparam Pipeline
+ * @tparam T
+ * @param src
+ * @param pipeline callable mapping a ranger over a chunk to the final ranger
+ * @param init
+ * @return T
+ */
+template <typename Iterator, typename Pipeline, typename T>
+T par_accumulate(const par_source<Iterator> &src, Pipeline pipeline, T init) {
+  std::vector<T> partials(src.num_chunks());
+
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    partials[i] = accumulate(std::move(rgr), T{});
+  });
+  for (auto &x : partials)
+    init = std::move(init) + std::move(x);
+  return init;
+}
+
+template <typename Iterator, typename T>
+T par_accumulate(const par_source<Iterator> &src, T init) {
+  return par_accumulate(src, detail::par::identity_pipeline{},
+                        std::move(init));
+}
+
+/**
+ * @brief par_for_each
+ *
+ * Feeds the cursors of `pipeline(all(chunk))` to the consumption function
+ * `dst` for every chunk of `src` in parallel. When `dst` returns `false`,
+ * chunks following the current one that have not started yet are cancelled
+ * (cancellation is checked at chunk granularity, preceding chunks are always
+ * completed). Note that `take` and similar adaptors inside `pipeline` apply
+ * per chunk. `dst` must be safe to call concurrently.
+ *
+ * @return `true` if the whole input was processed
+ */
+template <typename Iterator, typename Pipeline, typename Dst>
+bool par_for_each(const par_source<Iterator> &src, Pipeline pipeline,
+                  Dst dst) {
+  constexpr auto none = static_cast<std::size_t>(-1);
+  std::atomic<std::size_t> stop{none};
+
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    if (i > stop.load(std::memory_order_relaxed))
+      return;
+    if (!rgr(dst)) {
+      auto s = stop.load(std::memory_order_relaxed);
+      while (i < s && !stop.compare_exchange_weak(s, i))
+        ;
+    }
+  });
+  return stop.load() == none;
+}
+
+template <typename Iterator, typename Dst>
+bool par_for_each(const par_source<Iterator> &src, Dst dst) {
+  return par_for_each(src, detail::par::identity_pipeline{}, std::move(dst));
+}
+
+/**
+ * @brief par_top_k
+ *
+ * Parallel `top_k`: every chunk keeps a bounded heap of its first `k`
+ * elements in `cmp` order, and the per-chunk results are merged into a last
+ * heap of `k`.
+ *
+ * @tparam Iterator
+ * @tparam Pipeline
+ * @tparam Compare
+ * @param src
+ * @param pipeline callable mapping a ranger over a chunk to the final ranger
+ * @param k
+ * @param cmp
+ * @return std::vector<T>, sorted by `cmp`
+ */
+template <typename Iterator, typename Pipeline, typename Compare>
+auto par_top_k(const par_source<Iterator> &src, Pipeline pipeline,
+               std::size_t k, Compare cmp) {
+  using ranger = decltype(pipeline(all(src.chunk(0))));
+  using value_type = detail::cursor_value_t<typename ranger::cursor>;
+
+  std::vector<std::vector<value_type>> partials(src.num_chunks());
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    partials[i] = top_k(k, cmp, std::move(rgr));
+  });
+  detail::bounded_heap<value_type, Compare> h{k, cmp};
+  for (auto &v : partials)
+    for (auto &x : v) {
+      if (h.full() && !cmp(x, h.top()))
+        break; /* v is sorted, the rest of it can't get in either */
+      h.push(std::move(x));
+    }
+  return std::move(h).sorted();
+}
+
+template <typename Iterator, typename Compare>
+auto par_top_k(const par_source<Iterator> &src, std::size_t k, Compare cmp) {
+  return par_top_k(src, detail::par::identity_pipeline{}, k, std::move(cmp));
+}
+
+/**
+ * @brief par_nth
+ *
+ * Parallel `nth`, merging per-chunk heaps of `n + 1` elements as `par_top_k`
+ * does.
+ *
+ * @return std::optional<T>, empty if there are no more than `n` elements
+ */
+template <typename Iterator, typename Pipeline, typename Compare>
+auto par_nth(const par_source<Iterator> &src, Pipeline pipeline,
+             std::size_t n, Compare cmp) {
+  auto v = par_top_k(src, std::move(pipeline), n + 1, std::move(cmp));
+  using value_type = typename decltype(v)::value_type;
+  return v.size() > n ? std::optional<value_type>{std::move(v[n])}
+                      : std::nullopt;
+}
+
+template <typename Iterator, typename Compare>
+auto par_nth(const par_source<Iterator> &src, std::size_t n, Compare cmp) {
+  return par_nth(src, detail::par::identity_pipeline{}, n, std::move(cmp));
+}
+
+/**
+ * @brief par_min_max
+ *
+ * Parallel `min_max`: chunks are scanned with `min_max` and their results
+ * combined.
+ *
+ * @return std::optional<std::pair<T, T>>, empty if there are no elements
+ */
+template <typename Iterator, typename Pipeline>
+auto par_min_max(const par_source<Iterator> &src, Pipeline pipeline) {
+  using ranger = decltype(pipeline(all(src.chunk(0))));
+  using result_type = decltype(min_max(std::declval<ranger>()));
+
+  std::vector<result_type> partials(src.num_chunks());
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    partials[i] = min_max(std::move(rgr));
+  });
+  result_type res;
+  for (auto &x : partials) {
+    if (!x)
+      continue;
+    if (!res)
+      res = std::move(x);
+    else {
+      if (x->first < res->first)
+        res->first = std::move(x->first);
+      if (res->second < x->second)
+        res->second = std::move(x->second);
+    }
+  }
+  return res;
+}
+
+template <typename Iterator>
+auto par_min_max(const par_source<Iterator> &src) {
+  return par_min_max(src, detail::par::identity_pipeline{});
+}
+
+/**
+ * @brief par_quantile
+ *
+ * Parallel `quantile`: every chunk takes a reservoir sample of up to
+ * `sample_size` elements, and the quantile is looked up in the union of the
+ * samples, each element weighted by the number of chunk elements it stands
+ * for. Exact when no chunk has more than `sample_size` elements.
+ *
+ * @return std::optional<T>, empty if there are no elements
+ */
+template <typename Iterator, typename Pipeline,
+          std::enable_if_t<!std::is_arithmetic<Pipeline>::value, int> = 0>
+auto par_quantile(const par_source<Iterator> &src, Pipeline pipeline, double q,
+                  std::size_t sample_size = 4096) {
+  using ranger = decltype(pipeline(all(src.chunk(0))));
+  using value_type = detail::cursor_value_t<typename ranger::cursor>;
+  using reservoir = detail::reservoir<value_type>;
+
+  std::vector<std::optional<reservoir>> partials(src.num_chunks());
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    partials[i].emplace(detail::reservoir_of(sample_size, std::move(rgr), i));
+  });
+  std::vector<std::pair<value_type, double>> s;
+  std::uint64_t n = 0;
+  for (auto &r : partials) {
+    auto w = static_cast<double>(r->count()) /
+             static_cast<double>(r->sample().size());
+    for (auto &x : r->sample())
+      s.emplace_back(std::move(x), w);
+    n += r->count();
+  }
+  if (s.empty())
+    return std::optional<value_type>{};
+  std::sort(s.begin(), s.end(), [](const auto &x, const auto &y) {
+    return x.first < y.first;
+  });
+  auto rank = static_cast<double>(detail::quantile_rank(q, n)), acc = 0.0;
+  for (auto &x : s)
+    if ((acc += x.second) > rank)
+      return std::optional<value_type>{std::move(x.first)};
+  return std::optional<value_type>{std::move(s.back().first)};
+}
+
+template <typename Iterator>
+auto par_quantile(const par_source<Iterator> &src, double q,
+                  std::size_t sample_size = 4096) {
+  return par_quantile(src, detail::par::identity_pipeline{}, q, sample_size);
+}
+
+/**
+ * @brief par_find_if
+ *
+ * Parallel `find_if`: returns an iterator to the first element of `src`, in
+ * input order, satisfying `pred`, or `src.last` if there is none. Chunks are
+ * searched with `find_if`; a match cancels the chunks following it that have
+ * not started yet, as with `par_for_each`, while preceding chunks are
+ * always searched through, since they may hold an earlier match.
+ *
+ * @tparam Iterator
+ * @tparam Pred
+ * @param src
+ * @param pred
+ * @return Iterator
+ */
+template <typename Iterator, typename Pred>
+Iterator par_find_if(const par_source<Iterator> &src, Pred pred) {
+  constexpr auto none = static_cast<std::size_t>(-1);
+  std::atomic<std::size_t> stop{none};
+  std::vector<Iterator> found(src.num_chunks(), src.last);
+
+  detail::par::identity_pipeline pipeline;
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    if (i > stop.load(std::memory_order_relaxed))
+      return;
+    if (auto p = find_if(pred, rgr)) {
+      found[i] = *p;
+      auto s = stop.load(std::memory_order_relaxed);
+      while (i < s && !stop.compare_exchange_weak(s, i))
+        ;
+    }
+  });
+  auto s = stop.load();
+  return s == none ? src.last : found[s];
+}
+
+/**
+ * @brief par_any_of
+ *
+ * Parallel `any_of`: the first match found, in whichever chunk, cancels all
+ * the chunks that have not started yet.
+ *
+ * @tparam Iterator
+ * @tparam Pipeline
+ * @tparam Pred
+ * @param src
+ * @param pipeline callable mapping a ranger over a chunk to the final ranger
+ * @param pred
+ * @return bool
+ */
+template <typename Iterator, typename Pipeline, typename Pred>
+bool par_any_of(const par_source<Iterator> &src, Pipeline pipeline,
+                Pred pred) {
+  std::atomic<bool> found{false};
+
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t, auto rgr) {
+    if (found.load(std::memory_order_relaxed))
+      return;
+    if (any_of(pred, std::move(rgr)))
+      found.store(true, std::memory_order_relaxed);
+  });
+  return found.load();
+}
+
+template <typename Iterator, typename Pred>
+bool par_any_of(const par_source<Iterator> &src, Pred pred) {
+  return par_any_of(src, detail::par::identity_pipeline{}, std::move(pred));
+}
+
+/**
+ * @brief par_all_of
+ *
+ * Parallel `all_of`, cancelled as `par_any_of` is.
+ */
+template <typename Iterator, typename Pipeline, typename Pred>
+bool par_all_of(const par_source<Iterator> &src, Pipeline pipeline,
+                Pred pred) {
+  return !par_any_of(src, std::move(pipeline), std::not_fn(std::move(pred)));
+}
+
+template <typename Iterator, typename Pred>
+bool par_all_of(const par_source<Iterator> &src, Pred pred) {
+  return par_all_of(src, detail::par::identity_pipeline{}, std::move(pred));
+}
+
+/**
+ * @brief par_none_of
+ *
+ * Parallel `none_of`, cancelled as `par_any_of` is.
+ */
+template <typename Iterator, typename Pipeline, typename Pred>
+bool par_none_of(const par_source<Iterator> &src, Pipeline pipeline,
+                 Pred pred) {
+  return !par_any_of(src, std::move(pipeline), std::move(pred));
+}
+
+template <typename Iterator, typename Pred>
+bool par_none_of(const par_source<Iterator> &src, Pred pred) {
+  return par_none_of(src, detail::par::identity_pipeline{}, std::move(pred));
+}
+
+/**
+ * @brief par_count_if
+ *
+ * Parallel `count_if`: chunks are counted independently and the counts
+ * added up.
+ *
+ * @tparam Iterator
+ * @tparam Pipeline
+ * @tparam Pred
+ * @param src
+ * @param pipeline callable mapping a ranger over a chunk to the final ranger
+ * @param pred
+ * @return std::size_t
+ */
+template <typename Iterator, typename Pipeline, typename Pred>
+std::size_t par_count_if(const par_source<Iterator> &src, Pipeline pipeline,
+                         Pred pred) {
+  std::vector<std::size_t> partials(src.num_chunks());
+
+  detail::par::for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    partials[i] = count_if(pred, std::move(rgr));
+  });
+  std::size_t n = 0;
+  for (auto x : partials)
+    n += x;
+  return n;
+}
+
+template <typename Iterator, typename Pred>
+std::size_t par_count_if(const par_source<Iterator> &src, Pred pred) {
+  return par_count_if(src, detail::par::identity_pipeline{}, std::move(pred));
+}
+
+namespace detail::par {
+
+template <bool Inclusive, typename Ranger, typename OutputIterator,
+          typename T, typename Op>
+void scan_from(Ranger rgr, OutputIterator o, T acc, Op &op) {
+  rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+    if constexpr (Inclusive) {
+      acc = op(std::move(acc), *p);
+      *o++ = acc;
+    } else {
+      auto x = *p; /* o may alias the input */
+      *o++ = acc;
+      acc = op(std::move(acc), std::move(x));
+    }
+    return true;
+  }));
+}
+
+/* Two-pass block scan: chunk totals are computed in parallel, combined
+ * serially into the starting value of each chunk, and then every chunk is
+ * scanned in parallel from its starting value.
+ */
+template <bool Inclusive, typename Iterator, typename OutputIterator,
+          typename T, typename Op>
+OutputIterator scan(const par_source<Iterator> &src, OutputIterator out,
+                    T init, Op op) {
+  auto n = src.num_chunks();
+  if (n <= 1 || src.num_threads() <= 1) { /* a single pass does */
+    auto rng = subrange<Iterator>{src.first, src.last};
+    scan_from<Inclusive>(all(rng), out, std::move(init), op);
+    return out + static_cast<std::ptrdiff_t>(src.size());
+  }
+
+  std::vector<std::optional<T>> partials(n);
+  auto pipeline = identity_pipeline{};
+  for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    if (i + 1 == n) /* the total of the last chunk is not needed */
+      return;
+    auto &acc = partials[i];
+    rgr(make_exhaustive_consumer([&](const auto &p) TRANSRANGERS_HOT {
+      if (acc)
+        *acc = op(std::move(*acc), *p);
+      else
+        acc.emplace(*p);
+      return true;
+    }));
+  });
+
+  std::vector<T> starts;
+  starts.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    starts.push_back(i ? starts.back() : init);
+    if (i && partials[i - 1])
+      starts.back() = op(std::move(starts.back()), std::move(*partials[i - 1]));
+  }
+
+  auto cs = static_cast<std::ptrdiff_t>(src.chunk_size());
+  for_each_chunk(src, pipeline, [&](std::size_t i, auto rgr) {
+    scan_from<Inclusive>(std::move(rgr),
+                         out + static_cast<std::ptrdiff_t>(i) * cs,
+                         std::move(starts[i]), op);
+  });
+  return out + static_cast<std::ptrdiff_t>(src.size());
+}
+
+} // namespace detail::par
+
+/**
+ * @brief par_inclusive_scan
+ *
+ * Parallel inclusive prefix fold of `src` with the associative operation `op`
+ * into the random-access range starting at `out` (which can be `src` itself):
+ * `out[i] = init op x0 op ... op xi`. The input is read twice, once to total
+ * each chunk and once to write its prefixes, so the speedup is bounded by
+ * memory bandwidth rather than by the number of threads.
+ *
+ * @tparam Iterator
+ * @tparam OutputIterator
+ * @tparam T
+ * @tparam Op
+ * @param src
+ * @param out
+ * @param init
+ * @param op associative binary operation
+ * @return the end of the output range
+ */
+template <typename Iterator, typename OutputIterator, typename T,
+          typename Op = std::plus<>>
+OutputIterator par_inclusive_scan(const par_source<Iterator> &src,
+                                  OutputIterator out, T init, Op op = {}) {
+  return detail::par::scan<true>(src, out, std::move(init), std::move(op));
+}
+
+/**
+ * @brief par_exclusive_scan
+ *
+ * Like `par_inclusive_scan`, with `out[i] = init op x0 op ... op x(i-1)`.
+ *
+ * @tparam Iterator
+ * @tparam OutputIterator
+ * @tparam T
+ * @tparam Op
+ * @param src
+ * @param out
+ * @param init
+ * @param op associative binary operation
+ * @return the end of the output range
+ */
+template <typename Iterator, typename OutputIterator, typename T,
+          typename Op = std::plus<>>
+OutputIterator par_exclusive_scan(const par_source<Iterator> &src,
+                                  OutputIterator out, T init, Op op = {}) {
+  return detail::par::scan<false>(src, out, std::move(init), std::move(op));
+}
+
+
+namespace detail::par {
+
+/* Bounded queues of element batches. Batches are swapped in and out of the
+ * slots, so that once every slot has been used the vectors circulate between
+ * producers and consumer and no further allocation takes place.
+ */
+template <typename T> class spsc_batch_queue {
+public:
+  explicit spsc_batch_queue(std::size_t n) : n{n}, slots{new std::vector<T>[n]} {}
+
+  bool try_push(std::vector<T> &b) {
+    auto t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == n)
+      return false;
+    slots[t % n].swap(b);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(std::vector<T> &b) {
+    auto h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return false;
+    slots[h % n].swap(b);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::size_t n;
+  std::unique_ptr<std::vector<T>[]> slots;
+  alignas(64) std::atomic<std::size_t> head{0};
+  alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+/* Vyukov's bounded MPMC queue: the sequence number of a slot tells whether it
+ * is ready for the producer or the consumer of a given lap (which takes at
+ * least two slots to tell apart).
+ */
+template <typename T> class mpmc_batch_queue {
+public:
+  explicit mpmc_batch_queue(std::size_t n) : n{n}, cells{new cell[n]} {
+    for (std::size_t i = 0; i < n; ++i)
+      cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  bool try_push(std::vector<T> &b) {
+    auto pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &c = cells[pos % n];
+      auto d = static_cast<std::ptrdiff_t>(c.seq.load(std::memory_order_acquire) -
+                                           pos);
+      if (d == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          c.data.swap(b);
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (d < 0)
+        return false;
+      else
+        pos = tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  bool try_pop(std::vector<T> &b) {
+    auto pos = head.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &c = cells[pos % n];
+      auto d = static_cast<std::ptrdiff_t>(c.seq.load(std::memory_order_acquire) -
+                                           (pos + 1));
+      if (d == 0) {
+        if (head.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          c.data.swap(b);
+          c.seq.store(pos + n, std::memory_order_release);
+          return true;
+        }
+      } else if (d < 0)
+        return false;
+      else
+        pos = head.load(std::memory_order_relaxed);
+    }
+  }
+
+private:
+  struct cell {
+    std::atomic<std::size_t> seq;
+    std::vector<T> data;
+  };
+
+  std::size_t n;
+  std::unique_ptr<cell[]> cells;
+  alignas(64) std::atomic<std::size_t> head{0};
+  alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+/* spins briefly, then yields, then sleeps: waits on a full or empty queue
+ * are expected to be short, but the other side may also be blocked on I/O
+ */
+struct backoff {
+  void operator()() {
+    if (++n < 64)
+      return;
+    if (n < 1024)
+      std::this_thread::yield();
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  unsigned n = 0;
+};
+
+template <typename T, typename Queue> struct stage_state {
+  stage_state(std::size_t capacity, std::size_t num_producers)
+      : batch{std::max<std::size_t>(
+            std::min<std::size_t>(capacity, TRANSRANGERS_PIPELINE_BATCH), 1)},
+        q{std::max<std::size_t>((capacity + batch - 1) / batch, 2)},
+        producers{num_producers} {}
+
+  stage_state(const stage_state &) = delete;
+  stage_state &operator=(const stage_state &) = delete;
+
+  ~stage_state() {
+    cancelled.store(true, std::memory_order_relaxed);
+    for (auto &t : threads)
+      t.join();
+  }
+
+  /* false if the consumer went away */
+  bool push(std::vector<T> &b) {
+    for (backoff wait; !q.try_push(b); wait())
+      if (cancelled.load(std::memory_order_relaxed))
+        return false;
+    b.clear();
+    return true;
+  }
+
+  template <typename Ranger> void produce(Ranger &rgr) {
+    std::vector<T> b;
+    try {
+      b.reserve(batch);
+      rgr([&](const auto &p) TRANSRANGERS_HOT {
+        b.push_back(*p);
+        return b.size() < batch || push(b);
+      });
+    } catch (...) {
+      std::lock_guard<std::mutex> lk{error_mtx};
+      if (!error)
+        error = std::current_exception();
+    }
+    if (!b.empty()) /* last elements, or those before an exception */
+      push(b);
+    producers.fetch_sub(1, std::memory_order_release);
+  }
+
+  template <typename Ranger> void spawn(Ranger rgr) {
+    threads.emplace_back(
+        [this, rgr = std::move(rgr)]() mutable { produce(rgr); });
+  }
+
+  /* false at the end of the stream */
+  bool pop(std::vector<T> &b) {
+    for (backoff wait; !q.try_pop(b); wait()) {
+      if (producers.load(std::memory_order_acquire) == 0) {
+        if (q.try_pop(b))
+          return true;
+        std::lock_guard<std::mutex> lk{error_mtx};
+        if (error)
+          std::rethrow_exception(std::exchange(error, nullptr));
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::size_t batch;
+  Queue q;
+  std::atomic<std::size_t> producers;
+  std::atomic<bool> cancelled{false};
+  std::mutex error_mtx;
+  std::exception_ptr error;
+  std::vector<std::thread> threads;
+};
+
+template <typename T, typename Queue> class stage_ranger {
+public:
+  using cursor = T *;
+
+  explicit stage_ranger(std::unique_ptr<stage_state<T, Queue>> st)
+      : st{std::move(st)} {}
+
+  template <typename Dst> TRANSRANGERS_HOT bool operator()(Dst dst) {
+    for (;;) {
+      auto first = buf.data() + pos, last = buf.data() + buf.size();
+      if constexpr (is_batch_consumer<Dst>::value) {
+        constexpr auto W = Dst::batch_width;
+        while (static_cast<std::size_t>(last - first) >= W) {
+          auto b = span_batch<cursor, W>{first};
+          first += W;
+          if (!dst(b)) {
+            pos = static_cast<std::size_t>(first - buf.data());
+            return false;
+          }
+        }
+      }
+      while (first != last)
+        if (!dst(first++)) {
+          pos = static_cast<std::size_t>(first - buf.data());
+          return false;
+        }
+      buf.clear();
+      pos = 0;
+      if (done || !st->pop(buf)) {
+        done = true;
+        return true;
+      }
+    }
+  }
+
+private:
+  std::unique_ptr<stage_state<T, Queue>> st;
+  std::vector<T> buf;
+  std::size_t pos = 0;
+  bool done = false;
+};
+
+} // namespace detail::par
+
+/**
+ * @brief pipeline_stage
+ *
+ * Runs `rgr` on a thread of its own and returns a ranger over its output, so
+ * that the stages before and after run concurrently. Elements are copied
+ * into batches of up to TRANSRANGERS_PIPELINE_BATCH elements passed through a
+ * lock-free single-producer single-consumer queue holding about `capacity`
+ * elements; the producer waits while the queue is full. Destroying the
+ * returned ranger stops `rgr` at its next batch and joins the thread, and an
+ * exception thrown by `rgr` is rethrown by the returned ranger after the
+ * elements produced before it. The returned ranger is move-only and its
+ * cursors are `T*` into the current batch.
+ *
+ * @tparam Ranger
+ * @param rgr
+ * @param capacity
+ * @return auto
+ */
+template <typename Ranger>
+auto pipeline_stage(Ranger rgr, std::size_t capacity = 4096) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
+  using state =
+      detail::par::stage_state<value_type,
+                               detail::par::spsc_batch_queue<value_type>>;
+
+  auto st = std::make_unique<state>(capacity, 1);
+  st->spawn(std::move(rgr));
+  return detail::stage(
+      "pipeline_stage",
+      detail::par::stage_ranger<value_type,
+                                detail::par::spsc_batch_queue<value_type>>{
+          std::move(st)});
+}
+
+/**
+ * @brief pipeline_fan_in
+ *
+ * Like `pipeline_stage`, but runs each of `rgrs` on a thread of its own, all
+ * of them feeding a shared lock-free MPMC queue. Elements of one input keep
+ * their relative order; otherwise the output interleaves the inputs in
+ * whichever order their batches arrive.
+ *
+ * @tparam Ranger
+ * @tparam Rangers
+ * @param capacity
+ * @param rgr
+ * @param rgrs
+ * @return auto
+ */
+template <typename Ranger, typename... Rangers>
+auto pipeline_fan_in(std::size_t capacity, Ranger rgr, Rangers... rgrs) {
+  using value_type = detail::cursor_value_t<typename Ranger::cursor>;
+  using state =
+      detail::par::stage_state<value_type,
+                               detail::par::mpmc_batch_queue<value_type>>;
+
+  auto st = std::make_unique<state>(capacity, 1 + sizeof...(rgrs));
+  st->spawn(std::move(rgr));
+  (st->spawn(std::move(rgrs)), ...);
+  return detail::stage(
+      "pipeline_fan_in",
+      detail::par::stage_ranger<value_type,
+                                detail::par::mpmc_batch_queue<value_type>>{
+          std::move(st)});
+}
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_HOT_MUTABLE
+#undef TRANSRANGERS_HOT
+#endif
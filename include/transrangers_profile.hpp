@@ -0,0 +1,377 @@
+/* Transrangers: an efficient, composable design pattern for range processing.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+#ifndef JOAQUINTIDES_TRANSRANGERS_PROFILE_HPP
+#define JOAQUINTIDES_TRANSRANGERS_PROFILE_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "transrangers.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRANSRANGERS_PROFILE_RDTSC() __rdtsc()
+#elif (defined(__GNUC__) || defined(__clang__)) &&                             \
+    (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define TRANSRANGERS_PROFILE_RDTSC() __rdtsc()
+#endif
+
+/* Ranger instrumentation. profile::instrumented wraps a ranger and records,
+ * per stage:
+ *   - calls: invocations of the ranger (the first one plus every resume),
+ *   - stops: invocations that ended in an early stop,
+ *   - in/out: elements received from instrumented inputs and elements
+ *     passed downstream (out / in is the selectivity of a filter),
+ *   - ticks: time spent in the stage and upstream of it, with the time spent
+ *     in downstream consumers excluded; self ticks further exclude the time
+ *     of instrumented inputs. Ticks are TSC cycles on x86 and nanoseconds
+ *     elsewhere.
+ *
+ * profile::instrument(name, rgr) is active if TRANSRANGERS_PROFILE or
+ * TRANSRANGERS_INSTRUMENT is defined and returns rgr unchanged otherwise,
+ * so it can be left in release builds at no cost. With TRANSRANGERS_PROFILE,
+ * every transranger in transrangers.hpp and transrangers_ext.hpp is
+ * additionally instrumented (one stage per adaptor and ranger type) and
+ * linked to its inputs. Either macro must be defined consistently across the
+ * translation units of a program.
+ */
+
+namespace transrangers {
+
+namespace profile {
+
+#if defined(TRANSRANGERS_PROFILE) || defined(TRANSRANGERS_INSTRUMENT)
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+inline std::uint64_t ticks() {
+#if defined(TRANSRANGERS_PROFILE_RDTSC)
+  return TRANSRANGERS_PROFILE_RDTSC();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+/**
+ * @brief stage_stats
+ *
+ * Counters accumulated by all the rangers instrumented under the same stage.
+ */
+struct stage_stats {
+  stage_stats(std::size_t id, std::string name, bool linked)
+      : id{id}, name{std::move(name)}, linked{linked} {}
+
+  const std::size_t id;
+  const std::string name;
+  const bool linked; /* in and self_ticks are meaningful */
+  std::atomic<std::uint64_t> calls{0}, stops{0}, in{0}, out{0}, ticks{0},
+      self_ticks{0};
+};
+
+/**
+ * @brief registry
+ *
+ * Process-wide collection of stages, exportable as JSON or as a flat table.
+ */
+class registry {
+public:
+  static registry &instance() {
+    static registry r;
+    return r;
+  }
+
+  /* stage named name, created on first use */
+  stage_stats &get(const std::string &name) {
+    std::lock_guard<std::mutex> lck{mtx};
+    for (auto &s : stages)
+      if (!s.linked && s.name == name)
+        return s;
+    return stages.emplace_back(stages.size(), name, false);
+  }
+
+  /* new stage */
+  stage_stats &add(const std::string &name, bool linked) {
+    std::lock_guard<std::mutex> lck{mtx};
+    return stages.emplace_back(stages.size(), name, linked);
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lck{mtx};
+    for (auto &s : stages) {
+      for (auto *c : {&s.calls, &s.stops, &s.in, &s.out, &s.ticks,
+                      &s.self_ticks})
+        c->store(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::string to_json() const {
+    std::lock_guard<std::mutex> lck{mtx};
+    std::ostringstream os;
+    os << "[";
+    for (auto &s : stages) {
+      os << (s.id ? ",\n " : "\n ") << "{\"id\": " << s.id << ", \"name\": \""
+         << escape(s.name) << "\", \"calls\": " << load(s.calls)
+         << ", \"stops\": " << load(s.stops) << ", \"in\": ";
+      if (s.linked)
+        os << load(s.in);
+      else
+        os << "null";
+      os << ", \"out\": " << load(s.out) << ", \"ticks\": " << load(s.ticks)
+         << ", \"self_ticks\": "
+         << load(s.linked ? s.self_ticks : s.ticks) << "}";
+    }
+    os << (stages.empty() ? "]" : "\n]") << "\n";
+    return os.str();
+  }
+
+  std::string to_table() const {
+    std::lock_guard<std::mutex> lck{mtx};
+    std::ostringstream os;
+    os << "id\tname\tcalls\tstops\tin\tout\tselectivity\tticks\tself_ticks\n";
+    for (auto &s : stages) {
+      os << s.id << "\t" << s.name << "\t" << load(s.calls) << "\t"
+         << load(s.stops) << "\t";
+      if (s.linked) {
+        os << load(s.in) << "\t" << load(s.out) << "\t";
+        if (load(s.in))
+          os << static_cast<double>(load(s.out)) /
+                    static_cast<double>(load(s.in));
+        else
+          os << "-";
+      } else
+        os << "-\t" << load(s.out) << "\t-";
+      os << "\t" << load(s.ticks) << "\t"
+         << load(s.linked ? s.self_ticks : s.ticks) << "\n";
+    }
+    return os.str();
+  }
+
+private:
+  registry() = default;
+
+  static std::uint64_t load(const std::atomic<std::uint64_t> &x) {
+    return x.load(std::memory_order_relaxed);
+  }
+
+  static std::string escape(const std::string &str) {
+    std::string res;
+    for (char c : str) {
+      if (c == '"' || c == '\\')
+        res += '\\';
+      res += c;
+    }
+    return res;
+  }
+
+  mutable std::mutex mtx;
+  std::deque<stage_stats> stages; /* stable addresses */
+};
+
+inline std::string to_json() { return registry::instance().to_json(); }
+inline std::string to_table() { return registry::instance().to_table(); }
+inline void reset() { registry::instance().reset(); }
+
+namespace detail {
+
+/* Counters of a single ranger, shared by its copies, through which a stage
+ * measures what its inputs did during each of its calls.
+ */
+struct instance_counts {
+  std::uint64_t out = 0, ticks = 0;
+};
+
+/* number of elements in p, a cursor or a batch */
+template <typename T> std::uint64_t element_count(const T &p) {
+  if constexpr (is_batch<T>::value) {
+    std::uint64_t n = 0;
+    for (std::size_t i = 0; i < T::width; ++i)
+      n += p.active(i) ? 1 : 0;
+    return n;
+  } else {
+    (void)p;
+    return 1;
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief instrumented
+ *
+ * Ranger forwarding to `rgr` while recording its activity in `*stats`.
+ * Consumer marks, random-access and size hint members of `rgr` are forwarded
+ * as well; elements skipped with `advance` count as produced, and so do the
+ * active lanes of batches.
+ *
+ * @tparam Ranger
+ */
+template <typename Ranger> struct instrumented {
+  using cursor = typename Ranger::cursor;
+
+  instrumented(Ranger rgr, stage_stats *stats)
+      : rgr{std::move(rgr)}, stats{stats} {}
+  instrumented(const instrumented &) = default;
+
+  /* The counters stay with the moved-from ranger as well, as transrangers
+   * link to the counters of their inputs after moving them in.
+   */
+  instrumented(instrumented &&x)
+      : rgr{std::move(x.rgr)}, stats{x.stats}, counts{x.counts},
+        inputs{x.inputs} {}
+
+  template <typename Dst> bool operator()(Dst dst) {
+    std::uint64_t n = 0, down = 0, in0 = inputs_out(), up0 = inputs_ticks();
+    auto t0 = profile::ticks();
+    bool res =
+        rgr(transrangers::detail::consumer_like<Dst>([&](const auto &p) {
+          n += detail::element_count(p);
+          auto t = profile::ticks();
+          bool r = dst(p);
+          down += profile::ticks() - t;
+          return r;
+        }));
+    auto t = profile::ticks() - t0 - down;
+    auto up = inputs_ticks() - up0;
+
+    counts->out += n;
+    counts->ticks += t;
+    stats->calls.fetch_add(1, std::memory_order_relaxed);
+    if (!res)
+      stats->stops.fetch_add(1, std::memory_order_relaxed);
+    stats->in.fetch_add(inputs_out() - in0, std::memory_order_relaxed);
+    stats->out.fetch_add(n, std::memory_order_relaxed);
+    stats->ticks.fetch_add(t, std::memory_order_relaxed);
+    stats->self_ticks.fetch_add(t > up ? t - up : 0,
+                                std::memory_order_relaxed);
+    return res;
+  }
+
+  template <typename R = Ranger>
+  auto size() const -> decltype(std::declval<const R &>().size()) {
+    return rgr.size();
+  }
+  template <typename R = Ranger>
+  auto size_hint() const -> decltype(std::declval<const R &>().size_hint()) {
+    return rgr.size_hint();
+  }
+  template <typename R = Ranger>
+  auto at(std::size_t i) -> decltype(std::declval<R &>().at(i)) {
+    return rgr.at(i);
+  }
+  template <typename R = Ranger>
+  auto advance(std::size_t k) -> decltype(std::declval<R &>().advance(k)) {
+    rgr.advance(k);
+    counts->out += k;
+    stats->out.fetch_add(k, std::memory_order_relaxed);
+  }
+
+  std::uint64_t inputs_out() const {
+    std::uint64_t res = 0;
+    for (auto &c : inputs)
+      res += c->out;
+    return res;
+  }
+  std::uint64_t inputs_ticks() const {
+    std::uint64_t res = 0;
+    for (auto &c : inputs)
+      res += c->ticks;
+    return res;
+  }
+
+  Ranger rgr;
+  stage_stats *stats;
+  std::shared_ptr<detail::instance_counts> counts =
+      std::make_shared<detail::instance_counts>();
+  std::vector<std::shared_ptr<const detail::instance_counts>> inputs = {};
+};
+
+template <typename T> struct is_instrumented : std::false_type {};
+template <typename Ranger>
+struct is_instrumented<instrumented<Ranger>> : std::true_type {};
+
+/**
+ * @brief instrument
+ *
+ * Records the activity of `rgr` under the stage `name` (stages with the same
+ * name are merged). Returns `rgr` unchanged unless TRANSRANGERS_PROFILE or
+ * TRANSRANGERS_INSTRUMENT is defined.
+ *
+ * @tparam Ranger
+ * @param name
+ * @param rgr
+ * @return auto
+ */
+template <typename Ranger> auto instrument(const char *name, Ranger rgr) {
+  if constexpr (enabled)
+    return instrumented<Ranger>{std::move(rgr),
+                                &registry::instance().get(name)};
+  else {
+    (void)name;
+    return rgr;
+  }
+}
+
+/**
+ * @brief make_stage
+ *
+ * Instruments `rgr`, built from `inputs`, as a stage of its own (one per
+ * ranger type) linked to the instrumented inputs. Used by the transrangers
+ * under TRANSRANGERS_PROFILE.
+ *
+ * @tparam Ranger
+ * @tparam Inputs
+ * @param name
+ * @param rgr
+ * @param inputs
+ * @return instrumented<Ranger>
+ */
+template <typename Ranger, typename... Inputs>
+instrumented<Ranger> make_stage(const char *name, Ranger rgr,
+                                const Inputs &...inputs) {
+  static stage_stats &stats = registry::instance().add(
+      name, (is_instrumented<Inputs>::value || ...));
+
+  instrumented<Ranger> res{std::move(rgr), &stats};
+  auto link = [&](const auto &input) {
+    if constexpr (is_instrumented<std::decay_t<decltype(input)>>::value)
+      res.inputs.push_back(input.counts);
+  };
+  (void)link;
+  (link(inputs), ...);
+  return res;
+}
+
+} // namespace profile
+
+} // namespace transrangers
+
+#undef TRANSRANGERS_PROFILE_RDTSC
+#endif
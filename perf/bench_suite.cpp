@@ -0,0 +1,439 @@
+/* Transrangers benchmark suite.
+ *
+ * Copyright 2021 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/transrangers for project home page.
+ */
+
+/* Every adaptor is measured against a handwritten loop, range-v3 and, where
+ * the standard library provides the view, std::ranges, for several payload
+ * types and for input sizes from L1-resident to larger than a typical LLC.
+ * Results are reported per element and written as nanobench JSON.
+ *
+ *   bench_suite [output.json [name-filter]]
+ *
+ * Benchmark names are case/payload/size/implementation, e.g.
+ * "zip/double/4MiB/transrangers"; only names containing name-filter are run.
+ * Define TRANSRANGERS_BENCH_NO_RANGEV3 to build without range-v3.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#include <numeric>
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+#include <range/v3/numeric/accumulate.hpp>
+#include <range/v3/view/concat.hpp>
+#include <range/v3/view/drop.hpp>
+#include <range/v3/view/drop_last.hpp>
+#include <range/v3/view/enumerate.hpp>
+#include <range/v3/view/filter.hpp>
+#include <range/v3/view/join.hpp>
+#include <range/v3/view/take.hpp>
+#include <range/v3/view/transform.hpp>
+#include <range/v3/view/unique.hpp>
+#include <range/v3/view/zip.hpp>
+#endif
+#if __has_include(<ranges>)
+#include <ranges>
+#endif
+#include <string>
+#include <transrangers.hpp>
+#include <transrangers_any.hpp>
+#include <transrangers_ext.hpp>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct record {
+  int id;
+  float weight;
+  char tag[8];
+
+  friend bool operator==(const record &x, const record &y) {
+    return x.id == y.id;
+  }
+};
+
+/* Payload types and the integer key every benchmark computes on. */
+template <typename T> struct payload;
+
+template <> struct payload<int> {
+  static constexpr const char *name = "int";
+  static int make(int i) { return i; }
+  static int key(int x) { return x; }
+};
+
+template <> struct payload<double> {
+  static constexpr const char *name = "double";
+  static double make(int i) { return i + 0.5; }
+  static int key(double x) { return static_cast<int>(x); }
+};
+
+template <> struct payload<std::string> {
+  static constexpr const char *name = "string";
+  static std::string make(int i) { return std::to_string(i); }
+  static int key(const std::string &x) { return x.back() - '0'; }
+};
+
+template <> struct payload<record> {
+  static constexpr const char *name = "record";
+  static record make(int i) { return {i, i * 0.25f, "payload"}; }
+  static int key(const record &x) { return x.id; }
+};
+
+template <typename T> std::vector<T> make_range(std::size_t n, int dup = 1) {
+  std::vector<T> v;
+  v.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    v.push_back(payload<T>::make(static_cast<int>(i) / dup));
+  return v;
+}
+
+/* Input footprints: L1, L2, LLC-sized and beyond LLC. */
+constexpr std::size_t sizes[] = {16 << 10, 256 << 10, 4 << 20, 64 << 20};
+
+std::string size_name(std::size_t bytes) {
+  return bytes < (1 << 20) ? std::to_string(bytes >> 10) + "KiB"
+                           : std::to_string(bytes >> 20) + "MiB";
+}
+
+class suite {
+public:
+  explicit suite(std::string filter) : filter{std::move(filter)} {
+    bench.title("transrangers").unit("elem").warmup(1).relative(false);
+  }
+
+  template <typename F>
+  void run(const std::string &name, std::size_t n, F f) {
+    if (name.find(filter) == std::string::npos)
+      return;
+    bench.batch(n).run(name, [&] {
+      ankerl::nanobench::doNotOptimizeAway(f());
+    });
+  }
+
+  ankerl::nanobench::Bench bench;
+
+private:
+  std::string filter;
+};
+
+template <typename T> void run_cases(suite &s, std::size_t bytes) {
+  using P = payload<T>;
+
+  auto n = std::max<std::size_t>(bytes / sizeof(T), 64);
+  auto name = [&](const char *c, const char *impl) {
+    return std::string(c) + "/" + P::name + "/" + size_name(bytes) + "/" + impl;
+  };
+  auto key = [](const T &x) { return static_cast<long long>(P::key(x)); };
+  auto is_even = [](const T &x) { return P::key(x) % 2 == 0; };
+  auto x3 = [](const T &x) { return 3LL * P::key(x); };
+  auto sum2 = [](const auto &t) {
+    return static_cast<long long>(P::key(std::get<0>(t))) +
+           P::key(std::get<1>(t));
+  };
+  auto indexed = [](const auto &t) {
+    return static_cast<long long>(std::get<0>(t)) + P::key(std::get<1>(t));
+  };
+
+  auto v = make_range<T>(n);
+
+  // filter + transform
+
+  s.run(name("filter_transform", "handwritten"), n, [&] {
+    long long res = 0;
+    for (const auto &x : v)
+      if (is_even(x))
+        res += x3(x);
+    return res;
+  });
+  s.run(name("filter_transform", "transrangers"), n, [&] {
+    using namespace transrangers;
+    return accumulate(transform(x3, filter(is_even, all(v))), 0LL);
+  });
+  s.run(name("filter_transform", "transrangers_any"), n, [&] {
+    using namespace transrangers;
+    auto rgr = any_ranger<long long>{transform(x3, filter(is_even, all(v)))};
+    return accumulate(rgr, 0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("filter_transform", "rangev3"), n, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(v | filter(is_even) | transform(x3), 0LL);
+  });
+#endif
+#if defined(__cpp_lib_ranges)
+  s.run(name("filter_transform", "stdranges"), n, [&] {
+    long long res = 0;
+    for (auto x : v | std::views::filter(is_even) | std::views::transform(x3))
+      res += x;
+    return res;
+  });
+#endif
+
+  // zip
+
+  s.run(name("zip", "handwritten"), n, [&] {
+    long long res = 0;
+    for (std::size_t i = 0; i < v.size(); ++i)
+      res += sum2(std::tie(v[i], v[i]));
+    return res;
+  });
+  s.run(name("zip", "transrangers"), n, [&] {
+    using namespace transrangers;
+    return accumulate(transform(sum2, zip(all(v), all(v))), 0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("zip", "rangev3"), n, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(zip(v, v) | transform(sum2), 0LL);
+  });
+#endif
+#if defined(__cpp_lib_ranges_zip)
+  s.run(name("zip", "stdranges"), n, [&] {
+    long long res = 0;
+    for (auto x : std::views::zip(v, v) | std::views::transform(sum2))
+      res += x;
+    return res;
+  });
+#endif
+
+  // concat
+
+  s.run(name("concat", "handwritten"), 2 * n, [&] {
+    long long res = 0;
+    for (int i = 0; i < 2; ++i)
+      for (const auto &x : v)
+        res += key(x);
+    return res;
+  });
+  s.run(name("concat", "transrangers"), 2 * n, [&] {
+    using namespace transrangers;
+    return accumulate(transform(key, concat(all(v), all(v))), 0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("concat", "rangev3"), 2 * n, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(concat(v, v) | transform(key), 0LL);
+  });
+#endif
+#if defined(__cpp_lib_ranges_concat)
+  s.run(name("concat", "stdranges"), 2 * n, [&] {
+    long long res = 0;
+    for (auto x : std::views::concat(v, v) | std::views::transform(key))
+      res += x;
+    return res;
+  });
+#endif
+
+  // take
+
+  s.run(name("take", "handwritten"), n / 2, [&] {
+    long long res = 0;
+    for (std::size_t i = 0; i < n / 2; ++i)
+      res += key(v[i]);
+    return res;
+  });
+  s.run(name("take", "transrangers"), n / 2, [&] {
+    using namespace transrangers;
+    return accumulate(transform(key, take(static_cast<int>(n / 2), all(v))),
+                      0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("take", "rangev3"), n / 2, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(v | take(n / 2) | transform(key), 0LL);
+  });
+#endif
+#if defined(__cpp_lib_ranges)
+  s.run(name("take", "stdranges"), n / 2, [&] {
+    long long res = 0;
+    for (auto x : v | std::views::take(n / 2) | std::views::transform(key))
+      res += x;
+    return res;
+  });
+#endif
+
+  // enumerate
+
+  s.run(name("enumerate", "handwritten"), n, [&] {
+    long long res = 0;
+    for (std::size_t i = 0; i < v.size(); ++i)
+      res += static_cast<long long>(i) + key(v[i]);
+    return res;
+  });
+  s.run(name("enumerate", "transrangers"), n, [&] {
+    using namespace transrangers;
+    return accumulate(transform(indexed, enumerate(all(v))), 0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("enumerate", "rangev3"), n, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(enumerate(v) | transform(indexed), 0LL);
+  });
+#endif
+#if defined(__cpp_lib_ranges_enumerate)
+  s.run(name("enumerate", "stdranges"), n, [&] {
+    long long res = 0;
+    for (auto x : std::views::enumerate(v) | std::views::transform(indexed))
+      res += x;
+    return res;
+  });
+#endif
+
+  // skip_first, skip_last, skip_both
+
+  s.run(name("skip_first", "handwritten"), n - 1, [&] {
+    long long res = 0;
+    for (auto it = v.begin() + 1; it != v.end(); ++it)
+      res += key(*it);
+    return res;
+  });
+  s.run(name("skip_first", "transrangers"), n - 1, [&] {
+    using namespace transrangers;
+    return accumulate(transform(key, skip_first(v)), 0LL);
+  });
+  s.run(name("skip_last", "transrangers"), n - 1, [&] {
+    using namespace transrangers;
+    return accumulate(transform(key, skip_last(v)), 0LL);
+  });
+  s.run(name("skip_both", "transrangers"), n - 2, [&] {
+    using namespace transrangers;
+    return accumulate(transform(key, skip_both(v)), 0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("skip_first", "rangev3"), n - 1, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(v | drop(1) | transform(key), 0LL);
+  });
+  s.run(name("skip_last", "rangev3"), n - 1, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(v | drop_last(1) | transform(key), 0LL);
+  });
+  s.run(name("skip_both", "rangev3"), n - 2, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(v | drop(1) | drop_last(1) | transform(key),
+                              0LL);
+  });
+#endif
+#if defined(__cpp_lib_ranges)
+  s.run(name("skip_first", "stdranges"), n - 1, [&] {
+    long long res = 0;
+    for (auto x : v | std::views::drop(1) | std::views::transform(key))
+      res += x;
+    return res;
+  });
+#endif
+
+  // unique, over runs of 4 equal elements
+
+  auto u = make_range<T>(n, 4);
+
+  s.run(name("unique", "handwritten"), n, [&] {
+    long long res = 0;
+    for (auto it = u.begin(); it != u.end(); ++it)
+      if (it == u.begin() || !(*it == *(it - 1)))
+        res += key(*it);
+    return res;
+  });
+  s.run(name("unique", "transrangers"), n, [&] {
+    using namespace transrangers;
+    return accumulate(transform(key, unique(all(u))), 0LL);
+  });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+  s.run(name("unique", "rangev3"), n, [&] {
+    using namespace ranges::views;
+    return ranges::accumulate(u | unique | transform(key), 0LL);
+  });
+#endif
+
+  // join, with varying inner lengths
+
+  for (std::size_t m : {1, 16, 1024}) {
+    auto jname = [&](const char *impl) {
+      return "join" + std::to_string(m) + "/" + P::name + "/" +
+             size_name(bytes) + "/" + impl;
+    };
+    std::vector<std::vector<T>> vv;
+    for (std::size_t i = 0; i < n; i += m)
+      vv.emplace_back(v.begin() + i, v.begin() + std::min(n, i + m));
+
+    s.run(jname("handwritten"), n, [&] {
+      long long res = 0;
+      for (const auto &w : vv)
+        for (const auto &x : w)
+          res += key(x);
+      return res;
+    });
+    s.run(jname("transrangers"), n, [&] {
+      using namespace transrangers;
+      return accumulate(transform(key, ranger_join(all(vv))), 0LL);
+    });
+#if !defined(TRANSRANGERS_BENCH_NO_RANGEV3)
+    s.run(jname("rangev3"), n, [&] {
+      using namespace ranges::views;
+      return ranges::accumulate(vv | join | transform(key), 0LL);
+    });
+#endif
+#if defined(__cpp_lib_ranges)
+    s.run(jname("stdranges"), n, [&] {
+      long long res = 0;
+      for (auto x : vv | std::views::join | std::views::transform(key))
+        res += x;
+      return res;
+    });
+#endif
+  }
+
+  // partial_sum (in place, arithmetic payloads only)
+
+  if constexpr (std::is_arithmetic<T>::value) {
+    using value_type =
+        typename std::conditional_t<std::is_integral<T>::value,
+                                    std::make_unsigned<T>,
+                                    std::common_type<T>>::type;
+    std::vector<value_type> w(v.begin(), v.end());
+
+    s.run(name("partial_sum", "handwritten"), n, [&] {
+      value_type acc = 0;
+      for (auto &x : w)
+        x = acc = acc + x;
+      return acc;
+    });
+    s.run(name("partial_sum", "transrangers"), n, [&] {
+      using namespace transrangers;
+      return partial_sum(all(w), value_type(0));
+    });
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string output = argc > 1 ? argv[1] : "bench_suite.json";
+  suite s{argc > 2 ? argv[2] : ""};
+
+  for (auto bytes : sizes) {
+    run_cases<int>(s, bytes);
+    run_cases<double>(s, bytes);
+    run_cases<std::string>(s, bytes);
+    run_cases<record>(s, bytes);
+  }
+
+  std::ofstream os{output};
+  ankerl::nanobench::render(ankerl::nanobench::templates::json(), s.bench,
+                            os);
+  if (!os) {
+    std::cerr << "bench_suite: can't write " << output << "\n";
+    return 1;
+  }
+}
@@ -23,6 +23,8 @@
 #include <range/v3/view/unique.hpp>
 #include <range/v3/view/zip.hpp>
 #include <transrangers.hpp>
+#include <transrangers_ext.hpp>
+#include <transrangers_fused.hpp>
 #include <vector>
 
 int main() {
@@ -52,6 +54,13 @@ int main() {
     ret = accumulate(transform(x3, filter(is_even, all(rng1))), 0);
   };
 
+  auto test1_transrangers_fused = [&] {
+    namespace fused = transrangers::fused;
+
+    ret = fused::accumulate(
+        fused::transform(x3, fused::filter(is_even, fused::all(rng1))), 0);
+  };
+
   auto test1_rangev3 = [&] {
     using namespace ranges::views;
 
@@ -214,37 +223,57 @@ int main() {
   auto sum = [](const auto &p) { return std::get<0>(p) + std::get<1>(p); };
   auto rng6 = rng1;
 
-  // auto test6_handwritten=[&]
-  // {
-  //   int res=0;
-  //   for(auto x:rng6){
-  //     auto y=x+x3(x);
-  //     if(divisible_by_3(y))res+=y;
-  //   }
-  //   ret=res;
-  // };
-  //
-  // auto test6_transrangers=[&]
-  // {
-  //   using namespace transrangers;
-  //
-  //   ret=accumulate(
-  //     filter(divisible_by_3,
-  //       transform(sum,zip(all(rng6),transform(x3,all(rng6))))),0);
-  // };
-  //
-  // auto test6_rangev3=[&]
-  // {
-  //   using namespace ranges::views;
-  //
-  //   ret=ranges::accumulate(
-  //     zip(rng6,rng6|transform(x3))|transform(sum)|filter(divisible_by_3),0);
-  // };
-  //
+  auto test6_handwritten = [&] {
+    int res = 0;
+    for (auto x : rng6) {
+      auto y = x + x3(x);
+      if (divisible_by_3(y))
+        res += y;
+    }
+    ret = res;
+  };
+
+  auto test6_transrangers = [&] {
+    using namespace transrangers;
+
+    ret = accumulate(
+        filter(divisible_by_3,
+               transform(sum, zip(all(rng6), transform(x3, all(rng6))))),
+        0);
+  };
+
+  /* Hides the random-access capability of a ranger so that zip takes the
+   * general resumable path.
+   */
+  auto resumable = [](auto rgr) {
+    using cursor = typename decltype(rgr)::cursor;
+    return transrangers::ranger<cursor>(
+        [=](auto dst) mutable { return rgr(dst); });
+  };
+
+  auto test6_transrangers_resumable = [&] {
+    using namespace transrangers;
+
+    ret = accumulate(
+        filter(divisible_by_3,
+               transform(sum, zip(resumable(all(rng6)),
+                                  resumable(transform(x3, all(rng6)))))),
+        0);
+  };
+
+  auto test6_rangev3 = [&] {
+    using namespace ranges::views;
+
+    ret = ranges::accumulate(
+        zip(rng6, rng6 | transform(x3)) | transform(sum) | filter(divisible_by_3),
+        0);
+  };
+
   auto bench = ankerl::nanobench::Bench().minEpochIterations(50);
 
   bench.run("test1_handwritten", test1_handwritten);
   bench.run("test1_transrangers", test1_transrangers);
+  bench.run("test1_transrangers_fused", test1_transrangers_fused);
   bench.run("test1_rangev3", test1_rangev3);
 
   bench.run("test2_handwritten", test2_handwritten);
@@ -263,9 +292,10 @@ int main() {
   bench.run("test5_transrangers", test5_transrangers);
   bench.run("test5_rangev3", test5_rangev3);
 
-  // bench.run("test6_handwritten",test6_handwritten);
-  // bench.run("test6_transrangers",test6_transrangers);
-  // bench.run("test6_rangev3",test6_rangev3);
+  bench.run("test6_handwritten", test6_handwritten);
+  bench.run("test6_transrangers", test6_transrangers);
+  bench.run("test6_transrangers_resumable", test6_transrangers_resumable);
+  bench.run("test6_rangev3", test6_rangev3);
 
   ankerl::nanobench::render(ankerl::nanobench::templates::csv(), bench,
                             std::cout);
@@ -2,6 +2,7 @@
 
 #include <pyrange/enumerate.hpp>
 #include <pyrange/range.hpp>
+#include <pyrange/robin.hpp>
 #include <range/v3/view/all.hpp>
 #include <transranger_view.hpp>
 #include <transrangers.hpp>
@@ -66,3 +67,100 @@ TEST_CASE("Test transrangers (enumerate + input_view)") {
   }
   // CHECK_EQ(total, 5);
 }
+
+TEST_CASE("Test Robin, CompactRobin, robin_exclude") {
+  using namespace transrangers;
+
+  const auto R = fun::Robin<int>(5);
+  const auto C = fun::CompactRobin<int>(5);
+  for (int part = 0; part < 5; ++part) {
+    auto expected = std::vector<int>{};
+    for (auto k : R.exclude(part))
+      expected.push_back(k);
+    auto compact = std::vector<int>{};
+    for (auto k : C.exclude(part))
+      compact.push_back(k);
+    CHECK(compact == expected);
+    auto res = std::vector<int>{};
+    CHECK(robin_exclude(R, part)([&](const auto &p) {
+      res.push_back(*p);
+      return true;
+    }));
+    CHECK(res == expected);
+    CHECK_EQ(accumulate(robin_exclude(C, part), 0), 10 - part);
+  }
+
+  // random access: partial consumption and resumption
+  auto rgr = fun::robin_exclude(R, 2);
+  CHECK_EQ(rgr.size(), 4);
+  CHECK_EQ(*rgr.at(2), 0);
+  auto res = std::vector<int>{};
+  auto dst = [&](const auto &p) {
+    res.push_back(*p);
+    return res.size() != 2;
+  };
+  CHECK_FALSE(rgr(dst));
+  CHECK(rgr(dst));
+  CHECK(res == std::vector<int>{3, 4, 0, 1});
+  CHECK_EQ(accumulate(take(2, fun::robin_exclude(R, 3)), 0), 4 + 0);
+
+  auto pairs = std::vector<std::pair<int, int>>{};
+  C.exclude_all([&](int part, int other) { pairs.emplace_back(part, other); });
+  auto expected = std::vector<std::pair<int, int>>{};
+  for (int part = 0; part < 5; ++part)
+    for (auto k : R.exclude(part))
+      expected.emplace_back(part, k);
+  CHECK(pairs == expected);
+  CHECK(fun::CompactRobin<int>(1).exclude(0).begin() ==
+        fun::CompactRobin<int>(1).exclude(0).end());
+}
+
+TEST_CASE("Test py::range (random access, step)") {
+  using namespace transrangers;
+
+  auto to_vec = [](const auto &rng) {
+    auto v = std::vector<int>{};
+    for (auto x : rng)
+      v.push_back(x);
+    return v;
+  };
+  CHECK(to_vec(py::range(1, 10, 3)) == std::vector<int>{1, 4, 7});
+  CHECK(to_vec(py::range(10, 1, -4)) == std::vector<int>{10, 6, 2});
+  CHECK(to_vec(py::range(0, 9, 3)) == std::vector<int>{0, 3, 6});
+  CHECK(py::range(5, 1, 2).empty());
+  CHECK(py::range(1, 5, -1).empty());
+  CHECK_EQ(py::range(0, 10, 3)[3], 9);
+
+  auto R = py::range(2, 12);
+  CHECK_EQ(R.end() - R.begin(), 10);
+  CHECK_EQ(*(R.begin() + 4), 6);
+  CHECK_EQ(R.begin()[9], 11);
+
+  // sized, random-access rangers, batched for batch consumers
+  auto rgr = all(py::range(0, 100, 7));
+  static_assert(is_random_access_ranger<decltype(rgr)>::value);
+  CHECK_EQ(rgr.size(), 15);
+  CHECK_EQ(*rgr.at(2), 14);
+  auto sum = 0;
+  auto batches = 0;
+  CHECK(all(py::range(0, 100, 7))(make_batch_consumer<4>([&](const auto &p) {
+    if constexpr (is_batch<std::decay_t<decltype(p)>>::value) {
+      ++batches;
+      for (std::size_t i = 0; i < 4; ++i)
+        sum += p[i];
+    } else
+      sum += *p;
+    return true;
+  })));
+  CHECK_EQ(batches, 3);
+  CHECK_EQ(sum, 7 * 14 * 15 / 2);
+
+  auto sq = [](int x) { return x * x; };
+  CHECK_EQ(accumulate(transform(sq, all(py::range(10))), 0), 285);
+  CHECK_EQ(accumulate(take(3, all(py::range(100, 0, -10))), 0), 270);
+  auto dot = [](const auto &t) { return std::get<0>(t) * std::get<1>(t); };
+  CHECK_EQ(accumulate(transform(dot, zip2(all(py::range(4)),
+                                          all(py::range(10, 50, 10)))),
+                      0),
+           10 * 0 + 20 * 1 + 30 * 2 + 40 * 3);
+}
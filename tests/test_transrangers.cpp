@@ -2,6 +2,9 @@
 
 #include <transrangers.hpp>
 
+#include <memory>
+#include <optional>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -53,3 +56,253 @@ TEST_CASE("Test transrangers (map)") {
 
   CHECK_EQ(count, 4);
 }
+
+TEST_CASE("Test transrangers (batch protocol)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  auto rng = all(S);
+  auto total = 0, batches = 0, singles = 0;
+  auto pause = true;
+  auto dst = make_batch_consumer<4>([&](const auto &p) {
+    if constexpr (is_batch<std::decay_t<decltype(p)>>::value) {
+      ++batches;
+      for (std::size_t i = 0; i < 4; ++i)
+        if (p.active(i))
+          total += p[i];
+      return !std::exchange(pause, false);
+    } else {
+      ++singles;
+      total += *p;
+      return true;
+    }
+  });
+  CHECK_FALSE(rng(dst)); // stops after the first batch
+  CHECK_EQ(total, 0 + 1 + 2 + 3);
+  CHECK(rng(dst)); // resumes at element 4
+  CHECK_EQ(total, 55);
+  CHECK_EQ(batches, 2);
+  CHECK_EQ(singles, 3); // 8, 9 and 10 from the tail of the range
+}
+
+TEST_CASE("Test transrangers (batch fallback)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{1, 1, 2, 2, 3, 4, 4, 5, 6};
+  auto total = 0;
+  auto dst = make_batch_consumer<4>([&](const auto &p) {
+    static_assert(!is_batch<std::decay_t<decltype(p)>>::value);
+    total += *p;
+    return true;
+  });
+  unique(all(S))(dst);
+  CHECK_EQ(total, 21);
+  total = 0;
+  transform([](int a) { return 3 * a; },
+            filter([](int a) { return a % 2 == 0; }, all(S)))(dst);
+  CHECK_EQ(total, 3 * (2 + 2 + 4 + 4 + 6));
+}
+
+TEST_CASE("Test transrangers (random access)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{1, 2, 3, 4, 5, 6};
+  auto x3 = [](int x) { return 3 * x; };
+  auto is_odd = [](int a) { return a % 2 == 1; };
+
+  static_assert(is_random_access_ranger<decltype(all(S))>::value);
+  static_assert(is_random_access_ranger<decltype(transform(x3, all(S)))>::value);
+  static_assert(!is_sized_ranger<decltype(filter(is_odd, all(S)))>::value);
+
+  auto rng = take(4, drop(1, all(S)));
+  CHECK_EQ(rng.size(), 4);
+  CHECK_EQ(*rng.at(0), 2);
+  CHECK_EQ(accumulate(rng, 0), 2 + 3 + 4 + 5);
+  CHECK_EQ(accumulate(drop(2, filter(is_odd, all(S))), 0), 5);
+  CHECK_EQ(accumulate(take(10, all(S)), 0), 21);
+
+  auto cat = concat(all(S), all(S));
+  CHECK_EQ(cat.size(), 12);
+  CHECK_EQ(*cat.at(7), 2);
+  CHECK_EQ(accumulate(take(8, cat), 0), 21 + 1 + 2);
+
+  // zip2 over random-access inputs stops at the shorter one and resumes
+  auto sum = [](const auto &p) { return std::get<0>(p) + std::get<1>(p); };
+  auto zrng = transform(sum, zip2(all(S), drop(2, all(S))));
+  CHECK_EQ(zrng.size(), 4);
+  auto total = 0;
+  auto count = 0;
+  auto dst = [&](const auto &p) {
+    total += *p;
+    return ++count != 2;
+  };
+  CHECK_FALSE(zrng(dst));
+  CHECK_EQ(total, (1 + 3) + (2 + 4));
+  CHECK(zrng(dst));
+  CHECK_EQ(total, (1 + 3) + (2 + 4) + (3 + 5) + (4 + 6));
+}
+
+TEST_CASE("Test transrangers (exhaustive join)") {
+  using namespace transrangers;
+
+  auto S = std::vector<std::vector<int>>{{1, 2}, {}, {3}, {4, 5, 6}};
+  auto is_odd = [](int a) { return a % 2 == 1; };
+  CHECK_EQ(accumulate(filter(is_odd, ranger_join(all(S))), 0), 1 + 3 + 5);
+
+  // the mark reaches the subrangers through filter
+  auto probe = [](auto dst) {
+    static_assert(is_exhaustive_consumer<decltype(dst)>::value);
+    return true;
+  };
+  auto probes = std::vector<ranger_class<int *, decltype(probe)>>(2, {probe});
+  filter(is_odd, join(all(probes)))(make_exhaustive_consumer(
+      [](const auto &) { return true; }));
+
+  // a consumer that stops early still resumes inside a subranger
+  auto rng = ranger_join(all(S));
+  auto total = 0;
+  CHECK_FALSE(rng([&](const auto &p) {
+    total += *p;
+    return *p != 4;
+  }));
+  CHECK_EQ(accumulate(rng, total), 21);
+
+  auto sizes = transform([](const auto &srgr) { return srgr.size(); },
+                         ranger_join_segments(all(S)));
+  CHECK_EQ(accumulate(sizes, std::size_t(0)), 6);
+}
+
+TEST_CASE("Test transrangers (ownership)") {
+  using namespace transrangers;
+
+  // rvalue ranges are owned, and copies of the ranger own their own copy
+  auto rgr = drop(1, all(std::vector<int>{1, 2, 3, 4}));
+  auto dst = [](const auto &p) { return *p != 3; };
+  CHECK_FALSE(rgr(dst));
+  auto copy = std::optional<decltype(rgr)>{rgr};
+  CHECK_EQ(accumulate(std::move(rgr), 0), 4);
+  CHECK_EQ(accumulate(*copy, 0), 4); // resumes after 3 in its own vector
+  CHECK_EQ(accumulate(all(std::vector<int>(100, 1)), 0), 100);
+
+  // move-only function objects
+  auto two = std::make_unique<int>(2);
+  auto is_even = [d = std::make_unique<int>(2)](int a) { return a % *d == 0; };
+  auto times = [m = std::move(two)](int x) { return *m * x; };
+  auto S = std::vector<int>{1, 2, 3, 4};
+  auto mo = transform(std::move(times), filter(std::move(is_even), all(S)));
+  static_assert(!std::is_copy_constructible<decltype(mo)>::value);
+  CHECK_EQ(accumulate(std::move(mo), 0), 2 * (2 + 4));
+
+  // large function objects held by reference
+  struct lookup {
+    int operator()(int x) const { return table[x]; }
+    int table[1024];
+  };
+  static_assert(sizeof(transform(lookup{}, all(S))) > sizeof(lookup));
+  auto l = lookup{};
+  for (int i = 0; i < 1024; ++i)
+    l.table[i] = 10 * i;
+  auto byref = transform(std::cref(l), all(S));
+  static_assert(sizeof(byref) < sizeof(lookup));
+  CHECK_EQ(accumulate(byref, 0), 100);
+}
+
+TEST_CASE("Test transrangers (concat, concat_all)") {
+  using namespace transrangers;
+
+  auto A = std::vector<int>{1, 2};
+  auto B = std::vector<int>{};
+  auto C = std::vector<int>{3, 4, 5};
+  auto res = std::vector<int>{};
+  auto dst = [&](const auto &p) {
+    res.push_back(*p);
+    return false; // resume after every element
+  };
+  auto cat = concat(all(A), all(B), all(C), take(1, all(A)));
+  CHECK_EQ(cat.size(), 6);
+  while (!cat(dst))
+    ;
+  CHECK(res == std::vector<int>{1, 2, 3, 4, 5, 1});
+
+  auto ra = concat(all(A), all(B), all(C));
+  CHECK_EQ(*ra.at(3), 4);
+  ra.advance(3);
+  CHECK_EQ(ra.size(), 2);
+  CHECK_EQ(accumulate(std::move(ra), 0), 9);
+
+  // shards chosen at run time, copied from lvalues or moved
+  auto shards = std::vector<all_ranger<std::vector<int>::iterator>>{};
+  for (auto *v : {&A, &B, &C, &A})
+    shards.push_back({v->begin(), v->end()});
+  res.clear();
+  auto owned = concat_all(std::vector(shards));
+  CHECK_EQ(accumulate(concat_all(shards), 0), 18);
+  auto partial = concat_all(shards);
+  auto firsts = 0;
+  CHECK_FALSE(partial([&](const auto &) { return ++firsts != 3; }));
+  CHECK_EQ(accumulate(concat_all(shards), 0), 18); // shards left untouched
+  const auto &cshards = shards;
+  CHECK_EQ(accumulate(concat_all(cshards), 0), 18);
+  CHECK_EQ(owned.size(), 7);
+  while (!owned(dst))
+    ;
+  CHECK(res == std::vector<int>{1, 2, 3, 4, 5, 1, 2});
+  CHECK(owned(dst)); // exhausted
+  shards[1] = {C.begin(), C.end()};
+  CHECK_EQ(accumulate(concat_all(std::move(shards)), 0), 30);
+  CHECK_EQ(accumulate(concat_all(std::vector<decltype(all(A))>{}), 0), 0);
+}
+
+#if !defined(TRANSRANGERS_PROFILE) /* instrumented stages are not constexpr */
+namespace {
+
+constexpr int constexpr_pipeline() {
+  using namespace transrangers;
+
+  int a[] = {1, 1, 2, 3, 3, 3, 4, 5, 6};
+  int b[] = {10, 20, 30};
+  auto is_odd = [](int x) { return x % 2 == 1; };
+  auto sq = [](int x) { return x * x; };
+  return accumulate(transform(sq, filter(is_odd, unique(all(a)))), 0) +
+         accumulate(concat(take(2, all(b)), drop(2, all(b))), 0) * 100;
+}
+
+} // namespace
+
+TEST_CASE("Test transrangers (constexpr)") {
+  static_assert(constexpr_pipeline() == 1 + 9 + 25 + 6000);
+  CHECK_EQ(constexpr_pipeline(), 6035);
+}
+#endif
+
+TEST_CASE("Test transrangers (all_columns, project)") {
+  using namespace transrangers;
+
+  auto id = std::vector<int>{1, 2, 3, 4, 5};
+  auto price = std::vector<double>{1.5, 2.0, 0.5, 4.0, 3.0};
+  const int qty[] = {2, 0, 4, 1, 0, 99}; // longer column is truncated
+
+  auto rows = all_columns(id, price, qty);
+  CHECK_EQ(rows.size(), 5);
+  auto in_stock = project<2>([](int q) { return q > 0; });
+  auto revenue = project<1, 2>([](double p, int q) { return p * q; });
+  CHECK_EQ(accumulate(transform(revenue, filter(in_stock, rows)), 0.0),
+           1.5 * 2 + 0.5 * 4 + 4.0 * 1);
+  CHECK_EQ(accumulate(transform(project<0>(), filter(in_stock, rows)), 0),
+           1 + 3 + 4);
+
+  // references into the columns
+  auto rgr = all_columns(id, price);
+  rgr([](const auto &p) {
+    auto [i, x] = *p;
+    x *= i;
+    return true;
+  });
+  CHECK(price == std::vector<double>{1.5, 4.0, 1.5, 16.0, 15.0});
+  CHECK_EQ(rows.at(3).column<1>(), 16.0);
+  auto proj = transform(project<2, 0>(), drop(3, rows));
+  CHECK_EQ(proj.size(), 2);
+  auto t = *proj.at(1);
+  CHECK_EQ(std::get<0>(t), 0);
+  CHECK_EQ(&std::get<1>(t), &id[4]);
+}
@@ -0,0 +1,182 @@
+#include <doctest/doctest.h>
+
+#include <transrangers_any.hpp>
+#include <transrangers_ext.hpp>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("Test transrangers (any_ranger)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(200);
+  std::iota(S.begin(), S.end(), 0);
+  auto is_even = [](int a) { return a % 2 == 0; };
+  auto x3 = [](int x) { return 3 * x; };
+
+  // shape of the pipeline decided at run time
+  for (int stages = 0; stages < 4; ++stages) {
+    auto rgr = any_ranger<int>{all(S)};
+    auto expected = std::vector<int>(S);
+    if (stages & 1) {
+      rgr = filter(is_even, rgr);
+      expected.erase(std::remove_if(expected.begin(), expected.end(),
+                                    [&](int a) { return !is_even(a); }),
+                     expected.end());
+    }
+    if (stages & 2) {
+      rgr = transform(x3, rgr);
+      for (auto &x : expected)
+        x = x3(x);
+    }
+    auto res = std::vector<int>{};
+    CHECK(rgr([&](const auto &p) {
+      res.push_back(*p);
+      return true;
+    }));
+    CHECK(res == expected);
+  }
+
+  CHECK_EQ(accumulate(any_ranger<int>{}, 5), 5); // empty
+
+  // stop in the middle of a chunk, copy and resume both
+  auto rgr = any_ranger<long, 8>{filter(is_even, all(S))};
+  auto count = 0;
+  auto dst = [&](const auto &) { return ++count != 13; };
+  CHECK_FALSE(rgr(dst));
+  auto copy = rgr;
+  CHECK(rgr(dst));
+  CHECK_EQ(count, 100); // the stopping element is not fed again
+  CHECK_EQ(accumulate(copy, 0L), 100L * 99 - 12L * 13);
+  CHECK(rgr(dst)); // exhausted stays exhausted
+  CHECK_EQ(count, 100);
+
+  // batch consumers get batches out of the chunk buffer
+  auto seen = std::size_t(0);
+  auto bdst = make_batch_consumer<4>([&](const auto &p) {
+    if constexpr (is_batch<std::decay_t<decltype(p)>>::value)
+      seen += std::decay_t<decltype(p)>::width;
+    else
+      ++seen;
+    return true;
+  });
+  CHECK(any_ranger<int, 10>{all(S)}(bdst));
+  CHECK_EQ(seen, S.size());
+}
+
+TEST_CASE("Test transrangers (any_ranger, heap storage)") {
+  using namespace transrangers;
+
+  auto big = std::array<int, 64>{}; // does not fit in place
+  big[3] = 1;
+  auto S = std::vector<std::string>{"a", "bb", "ccc"};
+  auto rgr = any_ranger<std::size_t>{
+      transform([big](const std::string &s) { return s.size() + big[3]; },
+                all(S))};
+  auto copy = rgr;
+  CHECK_EQ(accumulate(rgr, std::size_t(0)), 9);
+  CHECK_EQ(accumulate(copy, std::size_t(0)), 9);
+
+  auto strs = any_ranger<std::string, 2>{all(S)};
+  auto moved = std::move(strs);
+  auto res = std::string{};
+  moved([&](const auto &p) {
+    res += *p;
+    return true;
+  });
+  CHECK_EQ(res, "abbccc");
+}
+
+namespace {
+
+/* throws when copied while armed */
+struct fragile {
+  fragile(int x) : x{x} {}
+  fragile(const fragile &y) : x{y.x} {
+    if (armed)
+      throw std::runtime_error{"fragile"};
+  }
+  fragile(fragile &&) = default;
+
+  static inline bool armed = false;
+  int x;
+};
+
+/* counts live objects */
+struct tracked {
+  tracked(int x) : x{x} { ++live; }
+  tracked(const tracked &y) : x{y.x} { ++live; }
+  ~tracked() { --live; }
+
+  static inline int live = 0;
+  int x;
+};
+
+} // namespace
+
+TEST_CASE("Test transrangers (any_ranger, assignment)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{1, 2, 3, 4, 5};
+  auto rgr = any_ranger<int, 2>{all(S)};
+  auto count = 0;
+  CHECK_FALSE(rgr([&](const auto &) { return ++count != 1; }));
+  auto &self = rgr;
+  rgr = self;
+  rgr = std::move(self);
+  CHECK_EQ(accumulate(rgr, 0), 2 + 3 + 4 + 5);
+
+  auto F = std::vector<fragile>{1, 2, 3};
+  auto src = any_ranger<fragile, 2>{all(F)};
+  count = 0;
+  CHECK_FALSE(src([&](const auto &) { return ++count != 1; }));
+  auto dst = any_ranger<fragile, 2>{all(F)};
+  fragile::armed = true;
+  CHECK_THROWS_AS(dst = src, std::runtime_error);
+  fragile::armed = false;
+  auto sum = 0;
+  CHECK(dst([&](const auto &p) {
+    sum += p->x;
+    return true;
+  }));
+  CHECK_EQ(sum, 1 + 2 + 3); // left unchanged
+}
+
+TEST_CASE("Test transrangers (any_ranger, pauses and exceptions)") {
+  using namespace transrangers;
+
+  // a pause of the wrapped ranger is propagated
+  auto S = std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  auto [a, b] = tee(all(S), 4);
+  auto rgr = any_ranger<int>{a};
+  auto res = std::vector<int>{};
+  auto push = [&](const auto &p) {
+    res.push_back(*p);
+    return true;
+  };
+  CHECK_FALSE(rgr(push)); // a stalled on b
+  CHECK(res.size() == 4);
+  CHECK(b([](const auto &) { return true; }) == false); // b stalls too
+  while (!rgr(push))
+    b([](const auto &) { return true; });
+  CHECK(res == S);
+
+  // elements already built when the ranger throws are destroyed
+  {
+    auto T = std::vector<int>{1, 2, 3, 4};
+    auto thrower = any_ranger<tracked, 8>{transform(
+        [](int x) {
+          if (x == 3)
+            throw std::runtime_error{"thrower"};
+          return tracked{x};
+        },
+        all(T))};
+    CHECK_THROWS_AS(thrower([](const auto &) { return true; }),
+                    std::runtime_error);
+  }
+  CHECK_EQ(tracked::live, 0);
+}
@@ -0,0 +1,95 @@
+#include <doctest/doctest.h>
+
+#include <transrangers_any.hpp>
+#include <transrangers_async.hpp>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Test transrangers (co_accumulate)") {
+  using namespace transrangers;
+
+  auto ch = async_channel<int>{16}; // producer blocks when 16 ahead
+  auto producer = std::thread{[&] {
+    for (int i = 0; i < 10000; ++i)
+      ch.push(i);
+    ch.close();
+  }};
+  auto is_even = [](int a) { return a % 2 == 0; };
+  auto x3 = [](int x) { return 3L * x; };
+  auto res = sync_wait(co_accumulate(
+      ch, [&](auto rgr) { return transform(x3, filter(is_even, rgr)); }, 0L));
+  producer.join();
+  CHECK_EQ(res, 3L * 2 * (4999L * 5000 / 2));
+
+  // a type-erased pipeline passes the starved source's pauses through
+  auto ch2 = async_channel<int>{16};
+  auto producer2 = std::thread{[&] {
+    for (int i = 0; i < 1000; ++i)
+      ch2.push(i);
+    ch2.close();
+  }};
+  auto res2 = sync_wait(co_accumulate(
+      ch2, [](auto rgr) { return any_ranger<long>{rgr}; }, 0L));
+  producer2.join();
+  CHECK_EQ(res2, 999L * 1000 / 2);
+}
+
+TEST_CASE("Test transrangers (co_for_each)") {
+  using namespace transrangers;
+
+  // all data available up front
+  auto ch = async_channel<std::string>{};
+  for (auto s : {"a", "bb", "ccc", "dddd"})
+    ch.push(s);
+  ch.close();
+  auto res = std::vector<std::size_t>{};
+  CHECK(sync_wait(co_for_each(
+      ch,
+      [](auto rgr) {
+        return transform([](const std::string &s) { return s.size(); },
+                         take(3, rgr));
+      },
+      [&](const auto &p) {
+        res.push_back(*p);
+        return true;
+      })));
+  CHECK(res == std::vector<std::size_t>{1, 2, 3});
+
+  // consumer stopping before the end of the stream
+  auto ch2 = async_channel<int>{4};
+  auto producer = std::thread{[&] {
+    for (int i = 0; i < 100; ++i)
+      ch2.push(i);
+    ch2.close();
+  }};
+  auto seen = std::vector<int>{};
+  CHECK_FALSE(sync_wait(co_for_each(
+      ch2, [](auto rgr) { return rgr; },
+      [&](const auto &p) {
+        seen.push_back(*p);
+        return *p != 41;
+      })));
+  // drain the rest so that the producer can finish
+  auto rest = std::vector<int>{};
+  CHECK(sync_wait(co_for_each(
+      ch2, [](auto rgr) { return rgr; },
+      [&](const auto &p) {
+        rest.push_back(*p);
+        return true;
+      })));
+  producer.join();
+  CHECK(seen == [] {
+    auto v = std::vector<int>(42);
+    for (int i = 0; i < 42; ++i)
+      v[i] = i;
+    return v;
+  }());
+  CHECK(!rest.empty());
+  CHECK_EQ(rest.back(), 99);
+}
+
+#endif
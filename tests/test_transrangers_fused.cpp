@@ -0,0 +1,67 @@
+#include <doctest/doctest.h>
+
+#include <transrangers_fused.hpp>
+
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+TEST_CASE("Test transrangers (fused)") {
+  namespace fused = transrangers::fused;
+
+  auto S = std::vector<int>(100);
+  std::iota(S.begin(), S.end(), 0);
+  auto is_even = [](int x) { return x % 2 == 0; };
+  auto divisible_by_3 = [](int x) { return x % 3 == 0; };
+  auto x3 = [](int x) { return 3 * x; };
+  auto plus1 = [](int x) { return x + 1; };
+
+  auto expected = transrangers::accumulate(
+      transrangers::transform(
+          plus1, transrangers::transform(
+                     x3, transrangers::filter(
+                             divisible_by_3,
+                             transrangers::filter(is_even,
+                                                  transrangers::all(S))))),
+      0);
+
+  auto pl = fused::transform(
+      plus1, fused::transform(
+                 x3, fused::filter(divisible_by_3,
+                                   fused::filter(is_even, fused::all(S)))));
+  // adjacent stages are folded: one filter and one transform remain
+  static_assert(std::tuple_size<decltype(pl.stages)>::value == 2);
+  CHECK_EQ(fused::accumulate(pl, 0), expected);
+
+  auto v = fused::to_vector(
+      fused::transform(x3, fused::filter(is_even, fused::all(S))));
+  CHECK_EQ(v.size(), 50);
+  CHECK_EQ(v[1], 6);
+  CHECK_EQ(v.capacity(), 100); // upper bound reserved
+
+  auto count = 0;
+  fused::for_each(
+      fused::filter(is_even, fused::transform(plus1, fused::all(S))),
+      [&](int x) { count += x % 2 == 0; });
+  CHECK_EQ(count, 50);
+}
+
+TEST_CASE("Test transrangers (fused stateful stages)") {
+  namespace fused = transrangers::fused;
+
+  auto S = std::vector<int>{5, 5, 5, 5};
+  auto index = [i = 0](int x) mutable { return x * i++; };
+  auto pl = fused::transform(index, fused::all(S));
+  CHECK_EQ(fused::accumulate(pl, 0), 5 * (0 + 1 + 2 + 3));
+  CHECK_EQ(fused::accumulate(pl, 0), 5 * (0 + 1 + 2 + 3)); // pl is copied
+
+  auto every_other = [n = 0](int) mutable { return n++ % 2 == 0; };
+  auto T = std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8};
+  auto is_odd = [](int x) { return x % 2 == 1; };
+  CHECK_EQ(fused::accumulate(fused::filter(every_other, fused::all(T)), 0),
+           1 + 3 + 5 + 7);
+  CHECK_EQ(fused::accumulate(
+               fused::filter(every_other, fused::filter(is_odd, fused::all(T))),
+               0),
+           1 + 5);
+}
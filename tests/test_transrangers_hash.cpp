@@ -0,0 +1,77 @@
+#include <doctest/doctest.h>
+
+#include <transrangers_ext.hpp>
+#include <transrangers_hash.hpp>
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+TEST_CASE("Test transrangers (distinct)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{3, 1, 3, 2, 1, 4, 2, 3};
+  CHECK(to_vector(distinct(all(S))) == std::vector<int>{3, 1, 2, 4});
+
+  auto is_even = [](int a) { return a % 2 == 0; };
+  auto rgr = distinct(filter(is_even, all(S)));
+  auto res = std::vector<int>{};
+  auto dst = [&](const auto &p) {
+    res.push_back(*p);
+    return false;
+  };
+  while (!rgr(dst))
+    ;
+  CHECK(res == std::vector<int>{2, 4});
+
+  // enough distinct elements to go through several rehashes
+  auto L = std::vector<long>{};
+  for (long i = 0; i < 5000; ++i)
+    L.push_back((i * 7919) % 1000);
+  CHECK_EQ(to_vector(distinct(filter(is_even, all(L)))).size(), 500);
+
+  auto W = std::vector<std::string>{"b", "a", "b", "c", "a"};
+  auto pool = std::pmr::unsynchronized_pool_resource{};
+  CHECK(to_vector(distinct(all(W), &pool)) ==
+        std::vector<std::string>{"b", "a", "c"});
+}
+
+TEST_CASE("Test transrangers (hash_join)") {
+  using namespace transrangers;
+
+  struct user {
+    int id;
+    std::string name;
+  };
+  struct order {
+    int user_id;
+    int amount;
+  };
+  auto U = std::vector<user>{{1, "ann"}, {2, "bob"}, {1, "ann2"}, {3, "cy"}};
+  auto O = std::vector<order>{{2, 10}, {1, 20}, {4, 30}, {1, 40}};
+
+  auto rgr = hash_join(
+      all(U), all(O), [](const user &u) { return u.id; },
+      [](const order &o) { return o.user_id; });
+  auto res = std::vector<std::string>{};
+  auto dst = [&](const auto &p) {
+    auto [u, o] = *p;
+    res.push_back(u.name + ":" + std::to_string(o.amount));
+    return res.size() != 2; // stops between the two matches of user 1
+  };
+  CHECK_FALSE(rgr(dst));
+  CHECK(rgr(dst));
+  CHECK(rgr(dst)); // exhausted
+  CHECK(res == std::vector<std::string>{"bob:10", "ann:20", "ann2:20", "ann:40",
+                                        "ann2:40"});
+
+  auto E = std::vector<order>{};
+  auto pool = std::pmr::unsynchronized_pool_resource{};
+  CHECK(to_vector(transform([](const auto &p) { return p.first.id; },
+                            hash_join(
+                                all(U), all(E),
+                                [](const user &u) { return u.id; },
+                                [](const order &o) { return o.user_id; },
+                                &pool)))
+            .empty());
+}
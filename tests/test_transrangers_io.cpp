@@ -0,0 +1,88 @@
+#if __has_include(<sys/mman.h>)
+
+#include <doctest/doctest.h>
+
+#include <transrangers_io.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+struct temp_file {
+  explicit temp_file(std::string_view contents) {
+    int fd = ::mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(::write(fd, contents.data(), contents.size()) ==
+            static_cast<::ssize_t>(contents.size()));
+    ::close(fd);
+  }
+  ~temp_file() { ::unlink(path); }
+
+  char path[32] = "/tmp/transrangers_XXXXXX";
+};
+
+} // namespace
+
+TEST_CASE("Test transrangers (mmap_lines)") {
+  using namespace transrangers;
+
+  temp_file f{"alpha\nbeta\n\ngamma"};
+  auto rng = mmap_lines(f.path);
+  auto size = [](std::string_view s) { return s.size(); };
+  CHECK_EQ(accumulate(transform(size, rng), std::size_t(0)), 5 + 4 + 0 + 5);
+
+  std::string seen;
+  CHECK_FALSE(rng([&](const auto &p) {
+    seen += *p;
+    return *p != "beta";
+  }));
+  CHECK_EQ(seen, "alphabeta");
+  CHECK(rng([&](const auto &p) {
+    seen += "|" + std::string(*p);
+    return true;
+  }));
+  CHECK_EQ(seen, "alphabeta||gamma");
+
+  temp_file empty{""};
+  CHECK_EQ(accumulate(transform(size, mmap_lines(empty.path)), 0), 0);
+  CHECK_THROWS_AS(mmap_lines("/nonexistent/transrangers"), std::system_error);
+}
+
+TEST_CASE("Test transrangers (mmap_records)") {
+  using namespace transrangers;
+
+  const std::int32_t data[] = {1, 2, 3, 4, 5};
+  temp_file f{std::string_view(reinterpret_cast<const char *>(data),
+                               sizeof(data) - 1)}; // last record is partial
+  auto rng = mmap_records<std::int32_t>(f.path);
+  CHECK_EQ(rng.size(), 4);
+  CHECK_EQ(accumulate(drop(1, rng), 0), 2 + 3 + 4);
+}
+
+TEST_CASE("Test transrangers (fd_chunks)") {
+  using namespace transrangers;
+
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  REQUIRE(::write(fds[1], "0123456789", 10) == 10);
+  ::close(fds[1]);
+
+  std::string seen;
+  auto chunks = 0;
+  CHECK(fd_chunks(fds[0], 4)([&](const auto &p) {
+    seen += *p;
+    ++chunks;
+    return true;
+  }));
+  ::close(fds[0]);
+  CHECK_EQ(seen, "0123456789");
+  CHECK_GE(chunks, 3);
+}
+
+#endif
@@ -0,0 +1,232 @@
+#include <doctest/doctest.h>
+
+#include <transrangers_par.hpp>
+
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+TEST_CASE("Test transrangers (par_accumulate)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(10007);
+  std::iota(S.begin(), S.end(), 0);
+  auto is_even = [](int x) { return x % 2 == 0; };
+  auto x3 = [](int x) { return 3 * x; };
+  auto pipeline = [&](auto rgr) { return transform(x3, filter(is_even, rgr)); };
+
+  auto expected = accumulate(pipeline(all(S)), 0LL);
+  auto total =
+      par_accumulate(par_all(S, par_policy{4, 100}), pipeline, 0LL);
+  CHECK_EQ(total, expected);
+  CHECK_EQ(par_accumulate(par_all(S), 1LL),
+           accumulate(all(S), 1LL)); // default policy, identity pipeline
+
+  // take applies per chunk: the first element of each chunk of 100
+  auto first = [](auto rgr) { return take(1, rgr); };
+  CHECK_EQ(accumulate(first(all(S)), 0LL), 0);
+  CHECK_EQ(par_accumulate(par_all(S, par_policy{4, 100}), first, 0LL),
+           100LL * (100 * 101 / 2));
+}
+
+TEST_CASE("Test transrangers (par_reduce)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{3, 9, 4, 1, 7, 2, 8, 6, 5};
+  auto max = [](int x, int y) { return x < y ? y : x; };
+  CHECK_EQ(par_reduce(par_all(S, par_policy{3, 2}), 0, max), 9);
+
+  auto is_odd = [](int a) { return a % 2 == 1; };
+  auto rng = par_all(S, par_policy{3, 2});
+  auto total = par_reduce(
+      rng, [&](auto rgr) { return filter(is_odd, rgr); }, 0,
+      [](int x, int y) { return x + y; });
+  CHECK_EQ(total, 3 + 9 + 1 + 7 + 5);
+  auto first = [](auto rgr) { return take(1, rgr); }; // per chunk
+  CHECK_EQ(par_reduce(rng, first, 0, max), 8); // max of 3, 4, 7, 8, 5
+
+  auto empty = std::vector<int>{};
+  CHECK_EQ(par_reduce(par_all(empty), 42, max), 42);
+}
+
+TEST_CASE("Test transrangers (par_for_each cancellation)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(1000);
+  std::iota(S.begin(), S.end(), 0);
+  std::atomic<int> count{0};
+  auto finished =
+      par_for_each(par_all(S, par_policy{1, 10}), [&](const auto &p) {
+        ++count;
+        return *p != 55;
+      });
+  CHECK_FALSE(finished);
+  CHECK_EQ(count.load(), 56); // single thread: chunks after the stop are skipped
+
+  count = 0;
+  CHECK(par_for_each(par_all(S), [&](const auto &) {
+    ++count;
+    return true;
+  }));
+  CHECK_EQ(count.load(), 1000);
+}
+
+TEST_CASE("Test transrangers (par_find_if, par_any_of, par_count_if)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(10007, 0);
+  S[1234] = S[5000] = S[9999] = 1;
+  auto is_one = [](int x) { return x == 1; };
+  auto rng = par_all(S, par_policy{4, 100});
+  CHECK_EQ(par_find_if(rng, is_one) - S.begin(), 1234);
+  CHECK(par_find_if(rng, [](int x) { return x > 1; }) == S.end());
+  CHECK(par_find_if(par_all(S), is_one) == S.begin() + 1234);
+
+  CHECK(par_any_of(rng, is_one));
+  CHECK_FALSE(par_all_of(rng, is_one));
+  CHECK(par_all_of(rng, [](int x) { return x >= 0; }));
+  CHECK_FALSE(par_none_of(rng, is_one));
+  auto is_zero = [](int x) { return x == 0; };
+  auto zeros = [&](auto rgr) { return filter(is_zero, rgr); };
+  CHECK(par_none_of(rng, zeros, is_one));
+  CHECK_EQ(par_count_if(rng, is_one), 3);
+  CHECK_EQ(par_count_if(rng, zeros, [](int) { return true; }), 10004);
+
+  // single thread: chunks after the match are never started
+  std::atomic<int> calls{0};
+  auto counted = [&](int x) {
+    ++calls;
+    return x == 1;
+  };
+  CHECK(par_any_of(par_all(S, par_policy{1, 100}), counted));
+  CHECK(calls.load() >= 1235);
+  CHECK(calls.load() < 1300);
+  calls = 0;
+  CHECK_EQ(par_find_if(par_all(S, par_policy{1, 100}), counted) - S.begin(),
+           1234);
+  CHECK(calls.load() < 1300);
+}
+
+TEST_CASE("Test transrangers (par_top_k, par_nth, par_min_max, par_quantile)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(10007);
+  for (int i = 0; i < 10007; ++i)
+    S[i] = (i * 7919) % 10007; // permutation of 0..10006
+  auto rng = par_all(S, par_policy{4, 500});
+  auto is_even = [](int x) { return x % 2 == 0; };
+  auto evens = [&](auto rgr) { return filter(is_even, rgr); };
+
+  CHECK(par_top_k(rng, 3, std::greater<>{}) ==
+        std::vector<int>{10006, 10005, 10004});
+  CHECK(par_top_k(rng, evens, 3, std::less<>{}) == std::vector<int>{0, 2, 4});
+  CHECK_EQ(*par_nth(rng, 1234, std::less<>{}), 1234);
+  CHECK_FALSE(par_nth(rng, 10007, std::less<>{}));
+
+  auto mm = par_min_max(rng, evens);
+  CHECK_EQ(mm->first, 0);
+  CHECK_EQ(mm->second, 10006);
+
+  CHECK_EQ(*par_quantile(rng, 0.5), 5003); // chunks fit the samples: exact
+  CHECK_EQ(*par_quantile(rng, evens, 0.5), 5002);
+  auto est = *par_quantile(rng, 0.25, 100);
+  CHECK(est > 2000);
+  CHECK(est < 3000);
+
+  auto empty = std::vector<int>{};
+  CHECK_FALSE(par_min_max(par_all(empty)));
+  CHECK_FALSE(par_quantile(par_all(empty), 0.5));
+  CHECK(par_top_k(par_all(empty), 3, std::less<>{}).empty());
+}
+
+TEST_CASE("Test transrangers (par_inclusive_scan, par_exclusive_scan)") {
+  using namespace transrangers;
+
+  auto S = std::vector<long>(1003);
+  std::iota(S.begin(), S.end(), 1);
+  auto expected = std::vector<long>(S.size());
+  std::inclusive_scan(S.begin(), S.end(), expected.begin(), std::plus<>{}, 5L);
+
+  auto out = std::vector<long>(S.size());
+  CHECK(par_inclusive_scan(par_all(S, par_policy{4, 10}), out.begin(), 5L) ==
+        out.end());
+  CHECK(out == expected);
+
+  std::exclusive_scan(S.begin(), S.end(), expected.begin(), 5L);
+  par_exclusive_scan(par_all(S, par_policy{4, 10}), S.begin(), 5L); // in place
+  CHECK(S == expected);
+
+  auto M = std::vector<int>{3, 1, 4, 1, 5, 9, 2, 6};
+  auto max = [](int x, int y) { return x < y ? y : x; };
+  par_inclusive_scan(par_all(M, par_policy{3, 3}), M.begin(), 0, max);
+  CHECK(M == std::vector<int>{3, 3, 4, 4, 5, 9, 9, 9});
+}
+
+TEST_CASE("Test transrangers (pipeline_stage)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(10007);
+  std::iota(S.begin(), S.end(), 0);
+  auto is_even = [](int x) { return x % 2 == 0; };
+  auto x3 = [](int x) { return 3 * x; };
+
+  auto expected = accumulate(transform(x3, filter(is_even, all(S))), 0LL);
+  CHECK_EQ(accumulate(transform(x3, pipeline_stage(filter(is_even, all(S)), 64)),
+                      0LL),
+           expected);
+  CHECK_EQ(accumulate(pipeline_stage(pipeline_stage(all(S), 1)), 0LL),
+           accumulate(all(S), 0LL)); // batches of one element
+
+  // resumable on the consumer side, stops the producer when destroyed
+  std::atomic<int> produced{0};
+  {
+    auto rgr = pipeline_stage(
+        transform(
+            [&](int x) {
+              ++produced;
+              return x;
+            },
+            all(S)),
+        100);
+    auto res = std::vector<int>{};
+    auto dst = [&](const auto &p) {
+      res.push_back(*p);
+      return res.size() % 10 != 0;
+    };
+    CHECK_FALSE(rgr(dst));
+    CHECK_FALSE(rgr(dst));
+    CHECK(res == std::vector<int>(S.begin(), S.begin() + 20));
+  }
+  CHECK(produced.load() < static_cast<int>(S.size()));
+
+  // exceptions are rethrown downstream
+  auto throwing = pipeline_stage(transform(
+      [](int x) {
+        if (x == 500)
+          throw x;
+        return x;
+      },
+      all(S)));
+  auto n = 0;
+  CHECK_THROWS_AS(throwing([&](const auto &) { return ++n, true; }), int);
+  CHECK_EQ(n, 500);
+}
+
+TEST_CASE("Test transrangers (pipeline_fan_in)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(5000);
+  std::iota(S.begin(), S.end(), 0);
+  auto is_odd = [](int x) { return x % 2 == 1; };
+  auto rgr = pipeline_fan_in(256, all(S), filter(is_odd, all(S)),
+                             take(10, all(S)));
+  auto res = std::vector<int>{};
+  CHECK(rgr([&](const auto &p) {
+    res.push_back(*p);
+    return true;
+  }));
+  CHECK_EQ(res.size(), 5000 + 2500 + 10);
+  auto sum = std::accumulate(res.begin(), res.end(), 0LL);
+  CHECK_EQ(sum, 4999LL * 5000 / 2 + 2500LL * 2500 + 45);
+}
@@ -0,0 +1,77 @@
+#include <doctest/doctest.h>
+
+/* TRANSRANGERS_INSTRUMENT is defined for the whole test target (xmake.lua) */
+#if !defined(TRANSRANGERS_INSTRUMENT) && !defined(TRANSRANGERS_PROFILE)
+#error "test_transranger must be built with TRANSRANGERS_INSTRUMENT defined"
+#endif
+#include <transrangers_profile.hpp>
+#include <transrangers.hpp>
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+TEST_CASE("Test transrangers (instrument)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(10);
+  std::iota(S.begin(), S.end(), 0);
+  auto is_even = [](int a) { return a % 2 == 0; };
+  auto rng = profile::instrument(
+      "test.even", filter(is_even, profile::instrument("test.src", all(S))));
+  auto &src = profile::registry::instance().get("test.src");
+  auto &even = profile::registry::instance().get("test.even");
+  CHECK_EQ(rng.stats, &even);
+
+  auto res = std::vector<int>{};
+  auto dst = [&](const auto &p) {
+    res.push_back(*p);
+    return res.size() != 2;
+  };
+  CHECK_FALSE(rng(dst)); // stops at 2
+  CHECK(rng(dst));       // resumes
+  CHECK(res == std::vector<int>{0, 2, 4, 6, 8});
+  CHECK_EQ(even.calls.load(), 2);
+  CHECK_EQ(even.stops.load(), 1);
+  CHECK_EQ(even.out.load(), 5);
+  CHECK_EQ(src.out.load(), 10);
+  CHECK_EQ(src.calls.load(), 2);
+
+  auto json = profile::to_json();
+  CHECK(json.find("\"name\": \"test.even\"") != std::string::npos);
+  CHECK(profile::to_table().find("test.src") != std::string::npos);
+
+  profile::reset();
+  CHECK_EQ(even.out.load(), 0);
+  accumulate(rng, 0);
+  CHECK_EQ(even.calls.load(), 1);
+  CHECK_EQ(even.stops.load(), 0);
+}
+
+TEST_CASE("Test transrangers (instrument, random access)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>{1, 2, 3, 4, 5};
+  auto rng = profile::instrument("test.ra", all(S));
+  CHECK(is_random_access_ranger<decltype(rng)>::value);
+  CHECK_EQ(accumulate(take(3, rng), 0), 1 + 2 + 3);
+  CHECK_EQ(profile::registry::instance().get("test.ra").out.load(), 3);
+}
+
+#if defined(TRANSRANGERS_PROFILE)
+TEST_CASE("Test transrangers (profile mode)") {
+  using namespace transrangers;
+
+  auto S = std::vector<int>(100);
+  std::iota(S.begin(), S.end(), 0);
+  auto rng =
+      filter([](int a) { return a % 4 == 0; }, filter([](int a) {
+               return a % 2 == 0;
+             }, all(S)));
+  CHECK_EQ(accumulate(rng, 0), 1200);
+  CHECK(rng.stats->linked);
+  CHECK_EQ(rng.stats->in.load(), 50); // selectivity 1/2
+  CHECK_EQ(rng.stats->out.load(), 25);
+  CHECK(profile::to_json().find("\"name\": \"filter\"") != std::string::npos);
+}
+#endif
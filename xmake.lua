@@ -5,6 +5,16 @@ add_requires("doctest", {alias = "doctest"})
 add_requires("range-v3", {alias = "range-v3"})
 -- add_requires("range-v3", {alias = "range-v3"})
 
+option("bench")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the benchmark targets (requires nanobench)")
+option_end()
+
+if has_config("bench") then
+    add_requires("nanobench", {alias = "nanobench"})
+end
+
 if is_mode("coverage") then
     add_cxflags("-ftest-coverage", "-fprofile-arcs", {force = true})
 end
@@ -22,15 +32,64 @@ target("test_transranger")
     set_kind("binary")
     add_includedirs("include", {public = true})
     add_files("tests/*.cpp")
+    -- for test_transrangers_profile.cpp; defined for every TU to keep
+    -- profile::instrument consistent across the binary
+    add_defines("TRANSRANGERS_INSTRUMENT")
     add_packages("range-v3", "doctest")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+-- the batched branches of select, min_max and count_if
+target("test_batch")
+    set_kind("binary")
+    add_includedirs("include", {public = true})
+    add_files("tests/*.cpp")
+    add_defines("TRANSRANGERS_INSTRUMENT", "TRANSRANGERS_BATCH_WIDTH=8")
+    add_packages("range-v3", "doctest")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+-- every transranger instrumented, incl. the "profile mode" test
+target("test_profile")
+    set_kind("binary")
+    add_includedirs("include", {public = true})
+    add_files("tests/*.cpp")
+    add_defines("TRANSRANGERS_PROFILE")
+    add_packages("range-v3", "doctest")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+target("test_async")
+    set_kind("binary")
+    set_languages("c++20") -- coroutines
+    add_includedirs("include", {public = true})
+    add_files("tests/main.cpp", "tests/test_transrangers_async.cpp")
+    add_packages("doctest")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+if has_config("bench") then
+    -- xmake f -m release --bench=y && xmake && xmake run bench_suite out.json
+    target("test_perf")
+        set_kind("binary")
+        set_optimize("fastest")
+        add_includedirs("include", {public = true})
+        add_files("perf/perf.cpp")
+        add_packages("range-v3", "nanobench")
+
+    target("bench_suite")
+        set_kind("binary")
+        set_languages("c++20") -- for the std::ranges comparisons
+        set_optimize("fastest")
+        add_includedirs("include", {public = true})
+        add_files("perf/bench_suite.cpp")
+        add_packages("range-v3", "nanobench")
+end
 
--- target("test_perf")
---     set_kind("binary")
---     add_includedirs("include", {public = true})
---     add_files("perf/*.cpp")
---     -- require nanobench installed
---     add_packages("range-v3")
---
 -- target("annex")
 --     set_kind("binary")
 --     add_includedirs("include", {public = true})